@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+static ArenaChunk *new_chunk(size_t min_size) {
+    size_t size = min_size > ARENA_CHUNK_SIZE ? min_size : ARENA_CHUNK_SIZE;
+    ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) return NULL;
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = ARENA_ALIGN(size);
+
+    if (!arena->head) {
+        arena->head = arena->current = new_chunk(size);
+        if (!arena->head) return NULL;
+    }
+
+    // 현재 청크에 자리가 없으면 다음 청크로 (reset 이후 남아 있는 청크를 먼저 재사용)
+    while (arena->current->used + size > arena->current->size) {
+        ArenaChunk *next = arena->current->next;
+        if (next && next->size >= size) {
+            next->used = 0;
+        } else {
+            ArenaChunk *chunk = new_chunk(size);
+            if (!chunk) return NULL;
+            chunk->next = next;          // 크기가 작은 청크는 뒤로 밀어 두고 계속 재사용
+            arena->current->next = chunk;
+            next = chunk;
+        }
+        arena->current = next;
+    }
+
+    void *p = arena->current->data + arena->current->used;
+    arena->current->used += size;
+    return p;
+}
+
+void *arena_calloc(Arena *arena, size_t size) {
+    void *p = arena_alloc(arena, size);
+    if (p) memset(p, 0, size);
+    return p;
+}
+
+char *arena_strndup(Arena *arena, const char *s, size_t len) {
+    char *p = arena_alloc(arena, len + 1);
+    if (!p) return NULL;
+    memcpy(p, s, len);
+    p[len] = '\0';
+    return p;
+}
+
+char *arena_strdup(Arena *arena, const char *s) {
+    return arena_strndup(arena, s, strlen(s));
+}
+
+void arena_reset(Arena *arena) {
+    // 각 청크의 used는 다시 사용하게 될 때 arena_alloc()에서 0으로 되돌린다
+    arena->current = arena->head;
+    if (arena->head) arena->head->used = 0;
+}
+
+void arena_free(Arena *arena) {
+    ArenaChunk *chunk = arena->head;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = arena->current = NULL;
+}
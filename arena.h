@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// 한 줄(명령어 하나)을 파싱하는 동안 쓰는 bump 할당기
+// 노드, 인자 문자열, 리다이렉션, heredoc 본문을 모두 여기서 할당하고
+// 실행이 끝나면 arena_reset()으로 한 번에 돌려준다. (개별 free 없음)
+
+#define ARENA_CHUNK_SIZE 8192
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t size;                 // data 크기
+    size_t used;                 // 사용한 바이트 수
+    char data[];
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk *head;            // 첫 번째 청크 (reset 후 여기서 다시 시작)
+    ArenaChunk *current;         // 현재 할당 중인 청크
+} Arena;
+
+void *arena_alloc(Arena *arena, size_t size);              // 8바이트 정렬된 메모리
+void *arena_calloc(Arena *arena, size_t size);             // 0으로 초기화된 메모리
+char *arena_strdup(Arena *arena, const char *s);
+char *arena_strndup(Arena *arena, const char *s, size_t len);
+void arena_reset(Arena *arena);                            // O(1): 청크는 재사용을 위해 유지
+void arena_free(Arena *arena);                             // 모든 청크 반환
+
+#endif // ARENA_H
@@ -0,0 +1,20 @@
+#!/bin/sh
+# make bench: 세 가지 벤치마크 결과를 JSON 하나로 모아 출력하고 bench/results.json에 저장
+#   micro: tokenize()/parse_command() 처리량 (bench/corpus의 스크립트)
+#   spawn: 내장 명령어, 외부 명령어, N단계 파이프라인 실행 지연
+#   e2e:   반복문, 리다이렉션, 큰 heredoc 스크립트 전체 실행 시간
+# 두 결과를 비교하려면 results.json을 따로 보관해 두고 diff 등으로 비교한다.
+
+OUT=${BENCH_OUT:-bench/results.json}
+
+{
+    printf '{\n"date": "%s",\n"host": "%s",\n' "$(date -u +%Y-%m-%dT%H:%M:%SZ)" "$(uname -srm)"
+    printf '"micro": '
+    ./bench/bench_parse 20 bench/corpus/*.sh
+    printf ',\n"spawn": '
+    ./bench/bench_spawn 500
+    printf ',\n"e2e": '
+    sh bench/e2e.sh ./MONGSHELL 5
+    printf '}\n'
+} > "$OUT" || exit 1
+cat "$OUT"
@@ -0,0 +1,110 @@
+// tokenize()와 parse_command() 처리량 측정 (MB/s, JSON 출력)
+// 사용법: bench_parse [반복 횟수] 스크립트...
+//   스크립트 하나를 반복해서 이어 붙여 1MB 이상으로 만든 뒤 측정한다.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokenizer.h"
+#include "parser.h"
+#include "arena.h"
+
+#define MIN_INPUT_SIZE (1024 * 1024)
+
+static char *read_file(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) { perror(path); exit(1); }
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = malloc(len + 1);
+    size_t n = fread(buf, 1, len, fp);
+    buf[n] = '\0';
+    fclose(fp);
+    *size = n;
+    return buf;
+}
+
+// 스크립트를 MIN_INPUT_SIZE 이상이 될 때까지 반복
+static char *repeat_script(const char *script, size_t len, size_t *out_len) {
+    size_t copies = len ? (MIN_INPUT_SIZE + len - 1) / len : 1;
+    char *buf = malloc(copies * (len + 1) + 1);
+    size_t n = 0;
+    for (size_t i = 0; i < copies; i++) {
+        memcpy(buf + n, script, len);
+        n += len;
+        if (len && script[len - 1] != '\n') buf[n++] = '\n';
+    }
+    buf[n] = '\0';
+    *out_len = n;
+    return buf;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// execute_tokens()와 같은 방식으로 명령어를 하나씩 파싱만 한다. 파싱한 명령어 수를 돌려줌
+static int parse_all(TokenList *tokens, const char *src, Arena *arena) {
+    TokenStream stream = { tokens->data, tokens->count, 0, src, arena };
+    int commands = 0;
+    while (1) {
+        Token *tok = peek_token(&stream);
+        if (!tok || tok->type == T_EOF) break;
+        if (tok->type == T_OPERATOR && (token_equals(src, tok, "\n") || token_equals(src, tok, ";"))) {
+            next_token(&stream);
+            continue;
+        }
+        int before = stream.pos;
+        Command *cmd = parse_command(&stream);
+        if (cmd) commands++;
+        arena_reset(arena);
+        if (!cmd || stream.pos == before) {
+            while ((tok = next_token(&stream)) && tok->type != T_EOF &&
+                   !(tok->type == T_OPERATOR && token_equals(src, tok, "\n")))
+                ;
+            if (!tok || tok->type == T_EOF) break;
+        }
+    }
+    return commands;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    TokenList tokens = { 0 };
+    Arena arena = { 0 };
+
+    printf("[");
+    for (int f = 2; f < argc; f++) {
+        size_t script_len, len;
+        char *script = read_file(argv[f], &script_len);
+        char *input = repeat_script(script, script_len, &len);
+        double mb = (double)len * iterations / (1024.0 * 1024.0);
+
+        tokenize(&tokens, input);   // 워밍업 (토큰 배열 크기 확보)
+        double begin = now_sec();
+        for (int i = 0; i < iterations; i++)
+            tokenize(&tokens, input);
+        double tokenize_sec = now_sec() - begin;
+
+        int commands = parse_all(&tokens, input, &arena);   // 워밍업 (arena 블록 확보)
+        begin = now_sec();
+        for (int i = 0; i < iterations; i++)
+            parse_all(&tokens, input, &arena);
+        double parse_sec = now_sec() - begin;
+
+        printf("%s\n  {\"script\": \"%s\", \"bytes\": %zu, \"iterations\": %d, \"tokens\": %d, \"commands\": %d, "
+               "\"tokenize_mb_s\": %.1f, \"parse_mb_s\": %.1f, \"parse_ns_per_command\": %.1f}",
+               f > 2 ? "," : "", argv[f], len, iterations, tokens.count, commands,
+               mb / tokenize_sec, mb / parse_sec, parse_sec * 1e9 / ((double)commands * iterations));
+        free(input);
+        free(script);
+    }
+    printf("\n]\n");
+
+    arena_free(&arena);
+    free_tokens(&tokens);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// 명령어 하나를 실행하는 지연 시간 측정 (내장 명령어, 외부 명령어, N단계 파이프라인. JSON 출력)
+// 사용법: bench_spawn [반복 횟수]
+//   쉘과 같은 경로(execute_tokens)로 실행하므로 파싱, 확장, spawn, 대기가 모두 포함된다.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "tokenizer.h"
+#include "parser.h"
+#include "executer.h"
+#include "builtins.h"
+#include "vars.h"
+
+extern char **environ;
+
+// batch: 한 샘플에 몇 번 실행할지 (내장 명령어는 한 번으로는 시계 해상도보다 짧음)
+static const struct {
+    const char *name;
+    const char *line;
+    int batch;
+} cases[] = {
+    { "builtin",          ":",                  100 },
+    { "builtin_redirect", "echo x > /dev/null", 100 },
+    { "external",         "/bin/true",          1 },
+    { "pipeline_2",       "/bin/true | /bin/true", 1 },
+    { "pipeline_4",       "/bin/true | /bin/true | /bin/true | /bin/true", 1 },
+    { "pipeline_8",       "/bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true", 1 },
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 500;
+    int ncases = sizeof(cases) / sizeof(cases[0]);
+    double *samples = malloc(iterations * sizeof(double));
+    TokenList tokens = { 0 };
+    Arena arena = { 0 };
+
+    vars_init(environ);
+    shell_pid = getpid();
+
+    printf("[");
+    for (int c = 0; c < ncases; c++) {
+        tokenize(&tokens, cases[c].line);
+        int batch = cases[c].batch;
+
+        for (int i = -1; i < iterations; i++) {   // i == -1: 워밍업 (경로 해시, 버퍼)
+            double begin = now_ns();
+            for (int k = 0; k < batch; k++) {
+                TokenStream stream = { tokens.data, tokens.count, 0, cases[c].line, &arena };
+                execute_tokens(&stream);
+            }
+            if (i >= 0) samples[i] = (now_ns() - begin) / batch;
+        }
+        out_flush();
+
+        double total = 0;
+        for (int i = 0; i < iterations; i++) total += samples[i];
+        qsort(samples, iterations, sizeof(double), compare_double);
+        printf("%s\n  {\"case\": \"%s\", \"command\": \"%s\", \"iterations\": %d, "
+               "\"avg_us\": %.2f, \"p50_us\": %.2f, \"p99_us\": %.2f, \"min_us\": %.2f}",
+               c ? "," : "", cases[c].name, cases[c].line, iterations * batch,
+               total / iterations / 1e3, samples[iterations / 2] / 1e3,
+               samples[(int)(iterations * 0.99)] / 1e3, samples[0] / 1e3);
+        fflush(stdout);
+    }
+    printf("\n]\n");
+
+    free(samples);
+    arena_free(&arena);
+    free_tokens(&tokens);
+    return 0;
+}
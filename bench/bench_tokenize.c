@@ -0,0 +1,76 @@
+// tokenize() 처리량 측정 (MB/s)
+// 사용법: bench_tokenize [스크립트 파일] [반복 횟수]
+//   파일을 주지 않으면 전형적인 명령어 줄로 8MB짜리 스크립트를 만들어 사용한다.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokenizer.h"
+
+#define GENERATED_SIZE (8 * 1024 * 1024)
+
+static const char *sample_lines[] = {
+    "for f in src/module_alpha.c src/module_beta.c src/module_gamma.c; do gcc -O2 -Wall -c $f; done\n",
+    "grep -rn --include=header_file_pattern deployment_configuration /etc/application/settings > /tmp/matches.txt 2>&1\n",
+    "echo \"deploying ${APP_NAME} to $TARGET_HOST with version $(cat VERSION)\" >> /var/log/deploy.log\n",
+    "if test -f /opt/service/current/config.yaml; then cp /opt/service/current/config.yaml /backup/; fi\n",
+    "cat access.log | awk '{print $1}' | sort | uniq -c | sort -rn | head -n 20 > top_clients.txt\n",
+    "rsync -az --delete --exclude=node_modules ./build/ deploy@web-server-01.internal:/srv/www/releases/\n",
+    "# generated step: synchronize configuration files across the cluster nodes\n",
+    "tar -czf archive-2024-release-candidate.tar.gz ./dist ./docs ./LICENSE && mv archive-2024-release-candidate.tar.gz /releases\n",
+};
+
+static char *generate_script(size_t size) {
+    char *buf = malloc(size + 1);
+    size_t n = 0, i = 0, nlines = sizeof(sample_lines) / sizeof(sample_lines[0]);
+    while (1) {
+        const char *line = sample_lines[i++ % nlines];
+        size_t len = strlen(line);
+        if (n + len > size) break;
+        memcpy(buf + n, line, len);
+        n += len;
+    }
+    buf[n] = '\0';
+    return buf;
+}
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) { perror(path); exit(1); }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buf = malloc(size + 1);
+    size_t n = fread(buf, 1, size, fp);
+    buf[n] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    char *input = argc > 1 ? read_file(argv[1]) : generate_script(GENERATED_SIZE);
+    int iterations = argc > 2 ? atoi(argv[2]) : 20;
+    size_t bytes = strlen(input);
+    TokenList tokens = { 0 };
+
+    tokenize(&tokens, input);  // 워밍업 (토큰 배열 크기 확보)
+
+    double begin = now_sec();
+    for (int i = 0; i < iterations; i++)
+        tokenize(&tokens, input);
+    double elapsed = now_sec() - begin;
+
+    double mb = (double)bytes * iterations / (1024.0 * 1024.0);
+    printf("tokenize: %.1f MB, %d tokens/pass, %.3f s, %.1f MB/s\n",
+           mb, tokens.count, elapsed, mb / elapsed);
+
+    free_tokens(&tokens);
+    free(input);
+    return 0;
+}
@@ -0,0 +1,28 @@
+# 소스 트리를 빌드하고 결과물을 정리하는 스크립트 (벤치마크용 예시)
+SRC_DIR=src
+OUT_DIR=build
+CFLAGS="-O2 -Wall -Wextra"
+
+if test ! -d $OUT_DIR; then
+    mkdir -p $OUT_DIR
+fi
+
+for f in $SRC_DIR/main.c $SRC_DIR/util.c $SRC_DIR/net.c $SRC_DIR/config.c; do
+    echo "compiling $f"
+    gcc $CFLAGS -c $f -o $OUT_DIR/${f##*/}.o 2> $OUT_DIR/errors.log || echo "failed: $f" >> $OUT_DIR/failures.txt
+done
+
+gcc -o $OUT_DIR/app $OUT_DIR/main.c.o $OUT_DIR/util.c.o $OUT_DIR/net.c.o $OUT_DIR/config.c.o && echo "linked $OUT_DIR/app"
+strip $OUT_DIR/app
+ls -l $OUT_DIR | grep -v total | sort -k5 -n > $OUT_DIR/sizes.txt
+
+cat > $OUT_DIR/VERSION <<END
+name=app
+built_by=${USER:-unknown}
+host=$(hostname)
+END
+
+if [ -f $OUT_DIR/failures.txt ]; then
+    cat $OUT_DIR/failures.txt
+    exit 1
+fi
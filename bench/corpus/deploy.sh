@@ -0,0 +1,26 @@
+# 여러 서버에 릴리스를 배포하는 스크립트 (벤치마크용 예시)
+APP_NAME=webfront
+RELEASE=${RELEASE:-$(date +%Y%m%d%H%M)}
+TARGETS="web-01 web-02 web-03 web-04"
+LOG=/var/log/deploy/${APP_NAME}.log
+
+echo "[$RELEASE] deploying ${APP_NAME} to $TARGETS" >> $LOG
+
+tar -czf /tmp/${APP_NAME}-${RELEASE}.tar.gz ./dist ./docs ./LICENSE || exit 1
+
+for host in $TARGETS; do
+    echo "==> $host"
+    scp -q /tmp/${APP_NAME}-${RELEASE}.tar.gz deploy@${host}:/srv/releases/ &&
+        ssh deploy@$host "tar -xzf /srv/releases/${APP_NAME}-${RELEASE}.tar.gz -C /srv/www" ||
+        echo "deploy to $host failed" >> $LOG
+    ssh deploy@$host 'systemctl reload nginx' > /dev/null 2>> $LOG &
+done
+wait
+
+if test "${VERIFY:-yes}" = yes; then
+    for host in $TARGETS; do
+        curl -fsS "http://$host/healthz" | grep -q ok || echo "$host unhealthy" >> $LOG
+    done
+fi
+rm -f /tmp/${APP_NAME}-${RELEASE}.tar.gz
+echo "[$RELEASE] done" >> $LOG
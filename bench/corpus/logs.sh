@@ -0,0 +1,20 @@
+# 접근 로그를 집계하는 스크립트 (벤치마크용 예시)
+LOG_DIR=${1:-/var/log/nginx}
+REPORT=/tmp/report.txt
+
+: > $REPORT
+for log in $LOG_DIR/access.log $LOG_DIR/access.log.1; do
+    test -f $log || continue
+    echo "== ${log##*/} ==" >> $REPORT
+    cat $log | awk '{print $1}' | sort | uniq -c | sort -rn | head -n 20 >> $REPORT
+    grep -c ' 500 ' $log >> $REPORT
+    grep ' 404 ' $log | awk '{print $7}' | sort | uniq -c | sort -rn | head -n 10 >> $REPORT
+done
+
+total=$(cat $LOG_DIR/access.log | wc -l)
+errors=$(grep -c ' 5[0-9][0-9] ' $LOG_DIR/access.log)
+printf "total=%s errors=%s\n" "$total" "$errors" >> $REPORT
+
+if [ "$errors" != 0 ]; then
+    mail -s "error report: ${errors} errors" ops@example.com < $REPORT
+fi
@@ -0,0 +1,70 @@
+#!/bin/sh
+# 스크립트 전체를 MONGSHELL로 실행하는 시간 측정 (JSON 출력)
+# 사용법: bench/e2e.sh [MONGSHELL 경로] [반복 횟수]
+# 반복문, 리다이렉션이 많은 스크립트, 큰 heredoc을 임시 디렉터리에 만들어서 실행한다.
+
+SHELL_BIN=${1:-./MONGSHELL}
+RUNS=${2:-5}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# 1. 반복문: 내장 명령어, 변수 확장, 조건문
+{
+    printf 'for i in'
+    awk 'BEGIN { for (i = 0; i < 20000; i++) printf " w%d", i }'
+    printf '; do\n'
+    printf '    x=$i\n'
+    printf '    if [ "$x" = w10000 ]; then echo half; fi\n'
+    printf '    : ${x#w} ${x%%0}\n'
+    printf 'done > /dev/null\n'
+} > "$WORK/loop.sh"
+
+# 2. 리다이렉션: 내장 명령어와 외부 명령어에 파일 열기/덧붙이기/읽기
+{
+    printf 'for i in'
+    awk 'BEGIN { for (i = 0; i < 500; i++) printf " %d", i }'
+    printf '; do\n'
+    printf '    echo line $i >> %s/out.txt\n' "$WORK"
+    printf '    echo line $i > %s/last.txt 2> /dev/null\n' "$WORK"
+    printf '    cat < %s/last.txt > /dev/null\n' "$WORK"
+    printf 'done\n'
+} > "$WORK/redirect.sh"
+
+# 3. 큰 heredoc: 20만 줄 본문을 확장해서 파이프로
+{
+    printf 'name=bench\n'
+    printf 'cat <<EOF | wc -l > /dev/null\n'
+    awk 'BEGIN { for (i = 0; i < 200000; i++) printf "row %d of $name with some padding text\n", i }'
+    printf 'EOF\n'
+    printf "cat <<'EOF' > /dev/null\n"
+    awk 'BEGIN { for (i = 0; i < 200000; i++) printf "raw row %d $not_expanded\n", i }'
+    printf 'EOF\n'
+} > "$WORK/heredoc.sh"
+
+now_ns() {
+    date +%s%N
+}
+
+printf '['
+sep=''
+for name in loop redirect heredoc; do
+    script="$WORK/$name.sh"
+    best=''
+    total=0
+    r=0
+    while [ $r -lt $RUNS ]; do
+        start=$(now_ns)
+        "$SHELL_BIN" "$script" > /dev/null || echo "e2e: $name failed" >&2
+        elapsed=$(( $(now_ns) - start ))
+        total=$((total + elapsed))
+        if [ -z "$best" ] || [ $elapsed -lt $best ]; then best=$elapsed; fi
+        r=$((r + 1))
+    done
+    bytes=$(wc -c < "$script")
+    printf '%s\n  {"script": "%s", "bytes": %d, "runs": %d, "avg_ms": %d.%03d, "min_ms": %d.%03d}' \
+        "$sep" "$name" "$bytes" "$RUNS" \
+        $((total / RUNS / 1000000)) $((total / RUNS / 1000 % 1000)) \
+        $((best / 1000000)) $((best / 1000 % 1000))
+    sep=','
+done
+printf '\n]\n'
@@ -0,0 +1,649 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include "builtins.h"
+#include "cmdhash.h"
+#include "prompt.h"
+#include "vars.h"
+#include "jobs.h"
+#include "stats.h"
+
+// ---- 내장 명령어 출력 버퍼 ----
+// echo, printf 등은 stdout(fd 1)에 바로 쓰지 않고 여기에 모았다가 write() 한 번으로 내보낸다.
+// 오류 메시지는 err_printf()/err_perror()로 쓴다. 먼저 버퍼를 내보내므로 2>&1 이어도 순서가 바뀌지 않는다.
+
+static char *out_buf = NULL;
+static size_t out_len = 0, out_cap = 0;
+static int out_tty = -1;          // fd 1이 터미널인지 (-1: 아직 모름)
+static int out_capturing = 0;     // $(...)를 쉘 안에서 실행 중이면 1 (내보내지 않음)
+
+void out_flush(void) {
+    if (out_capturing) return;
+    fflush(stdout);               // stdio로 쓴 출력이 있으면 순서를 지키도록 먼저
+    size_t off = 0;
+    while (off < out_len) {
+        ssize_t n = write(STDOUT_FILENO, out_buf + off, out_len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) break;         // EPIPE 등: 남은 출력은 버림
+        off += n;
+    }
+    out_len = 0;
+}
+
+void out_write(const char *s, size_t len) {
+    if (out_len + len > out_cap) {
+        size_t new_cap = out_cap ? out_cap : OUT_FLUSH_SIZE;
+        while (new_cap < out_len + len) new_cap *= 2;
+        char *grown = realloc(out_buf, new_cap);
+        if (!grown) {
+            out_flush();
+            if (write(STDOUT_FILENO, s, len) < 0) perror("write");
+            return;
+        }
+        out_buf = grown;
+        out_cap = new_cap;
+    }
+    memcpy(out_buf + out_len, s, len);
+    out_len += len;
+    if (!out_capturing && out_len >= OUT_FLUSH_SIZE) out_flush();
+}
+
+void out_printf(const char *fmt, ...) {
+    char small[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(small, sizeof(small), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n < sizeof(small)) {
+        out_write(small, n);
+        return;
+    }
+    char *big = malloc(n + 1);
+    if (!big) return;
+    va_start(ap, fmt);
+    vsnprintf(big, n + 1, fmt, ap);
+    va_end(ap);
+    out_write(big, n);
+    free(big);
+}
+
+void err_printf(const char *fmt, ...) {
+    out_flush();                  // 앞서 모아 둔 stdout 출력이 오류 메시지보다 먼저 나가도록
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+void err_perror(const char *s) {
+    int saved = errno;            // out_flush()의 write()가 errno를 바꿀 수 있음
+    out_flush();
+    errno = saved;
+    perror(s);
+}
+
+void out_fd_changed(void) {
+    out_tty = -1;
+}
+
+void out_capture_begin(void) {
+    out_flush();                  // 앞선 출력은 원래대로 내보내고 빈 버퍼에서 시작
+    out_capturing = 1;
+}
+
+const char *out_capture_end(size_t *len) {
+    *len = out_len;
+    out_len = 0;
+    out_capturing = 0;
+    return out_buf ? out_buf : "";
+}
+
+void out_end_command(void) {
+    if (out_len == 0 || out_capturing) return;
+    if (out_tty < 0) out_tty = isatty(STDOUT_FILENO);
+    if (out_tty) out_flush();     // 터미널이면 명령어마다 바로 보이도록
+}
+
+static int builtin_cd(char **args) {
+    const char *path = args[1];
+
+    if (!path) {
+        // case: cd
+        path = var_get("HOME");
+    } else if (strcmp(path, "~") == 0) {
+        // case: cd ~
+        path = var_get("HOME");
+    } else if (strcmp(path, "-") == 0) {
+        // case: cd -
+        path = var_get("OLDPWD");
+        if (path)
+            out_printf("%s\n", path); // cd -는 이동 경로 출력해야 함
+    } else if (path[0] == '~') {
+        // case: cd ~/something
+        const char *home = var_get("HOME");
+        if (home) {
+            static char expanded[1024];
+            snprintf(expanded, sizeof(expanded), "%s%s", home, path + 1); // '~' 이후 경로 붙이기
+            path = expanded;
+        }
+    }
+
+    if (!path || chdir(path) != 0) {
+        err_perror("cd");
+        return 1;
+    }
+
+    // OLDPWD 업데이트
+    const char *old = var_get("PWD");
+    if (old) var_set("OLDPWD", old, 0);
+    char cwd[1024];
+    if (getcwd(cwd, sizeof(cwd)))
+        var_set("PWD", cwd, 0);
+    prompt_update_cwd();   // 프롬프트의 디렉터리 부분은 여기서만 갱신
+
+    return 0;
+}
+
+static int builtin_pwd(char **args) {
+    int use_physical = 0; // -P 옵션 여부
+
+    // 옵션 파싱
+    if (args[1]) {
+        if (strcmp(args[1], "-P") == 0) {
+            use_physical = 1;
+        } else if (strcmp(args[1], "-L") != 0) {
+            err_printf("pwd: invalid option -- '%s'\n", args[1]);
+            return 1;
+        }
+    }
+
+    if (use_physical) {
+        char real[1024];
+        if (getcwd(real, sizeof(real)))
+            out_printf("%s\n", real);
+        else
+            err_perror("pwd");
+    } else {
+        // 논리 경로: PWD 환경변수 사용
+        const char *pwd = var_get("PWD");
+        if (pwd && *pwd)
+            out_printf("%s\n", pwd);
+        else {
+            // Fallback
+            char cwd[1024];
+            if (getcwd(cwd, sizeof(cwd)))
+                out_printf("%s\n", cwd);
+            else
+                err_perror("pwd");
+        }
+    }
+    return 0;
+}
+
+static int builtin_exit(char **args) {
+    out_flush();
+    exit(args[1] ? atoi(args[1]) : 0);
+}
+
+// exec [명령어 [인자...]]: 리다이렉션은 호출 전에 쉘 자신에게 적용되어 있다 (BUILTIN_KEEP_REDIRECTS).
+// 명령어가 없으면 그 fd들이 이후 명령어에 계속 이어지고, 있으면 쉘을 그 명령어로 바꾼다.
+static int builtin_exec(char **args) {
+    if (!args[1]) return 0;
+
+    const char *path = cmdhash_lookup(args[1]);
+    if (!path) {
+        err_printf("exec: %s: not found\n", args[1]);
+        return 127;
+    }
+    out_flush();
+    execve(path, args + 1, var_environ());
+    err_printf("exec: %s: %s\n", args[1], strerror(errno));
+    return errno == ENOENT ? 127 : 126;
+}
+
+static int builtin_true(char **args) {
+    (void)args;
+    return 0;
+}
+
+static int builtin_false(char **args) {
+    (void)args;
+    return 1;
+}
+
+static int builtin_colon(char **args) {
+    (void)args;
+    return 0;
+}
+
+// \n, \t, \\, \0nnn, \xHH 등 역슬래시 이스케이프를 해석해서 출력한다.
+// \c를 만나면 1을 반환 (이후 출력 중단)
+static int write_escaped(const char *s, int octal_needs_zero) {
+    for (const char *p = s; *p; p++) {
+        if (*p != '\\' || !p[1]) {
+            const char *q = p;
+            while (q[1] && q[1] != '\\') q++;   // 이스케이프가 없는 구간은 한 번에
+            out_write(p, q - p + 1);
+            p = q;
+            continue;
+        }
+        char c;
+        switch (*++p) {
+            case 'a': c = '\a'; break;
+            case 'b': c = '\b'; break;
+            case 'c': return 1;
+            case 'e': c = 27; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'v': c = '\v'; break;
+            case '\\': c = '\\'; break;
+            case 'x': {
+                int v = 0, n = 0;
+                while (n < 2 && isxdigit((unsigned char)p[1])) {
+                    p++;
+                    v = v * 16 + (isdigit((unsigned char)*p) ? *p - '0' : (tolower((unsigned char)*p) - 'a' + 10));
+                    n++;
+                }
+                if (n == 0) { out_write("\\x", 2); continue; }
+                c = (char)v;
+                break;
+            }
+            case '0': case '1': case '2': case '3':
+            case '4': case '5': case '6': case '7': {
+                // echo -e는 \0nnn, printf는 \nnn 형식
+                if (octal_needs_zero && *p != '0') { out_write(p - 1, 2); continue; }
+                int v = 0, n = 0, max = (octal_needs_zero && *p == '0') ? 3 : 2;
+                if (!(octal_needs_zero && *p == '0')) v = *p - '0';
+                while (n < max && p[1] >= '0' && p[1] <= '7') {
+                    p++;
+                    v = v * 8 + (*p - '0');
+                    n++;
+                }
+                c = (char)v;
+                break;
+            }
+            default:
+                out_write(p - 1, 2);      // 알 수 없는 이스케이프는 그대로
+                continue;
+        }
+        out_write(&c, 1);
+    }
+    return 0;
+}
+
+static int builtin_echo(char **args) {
+    int newline = 1, escapes = 0, i = 1;
+
+    // -n, -e, -E 및 그 조합 (예: -ne)만 옵션으로 인정
+    for (; args[i] && args[i][0] == '-' && args[i][1]; i++) {
+        const char *p = args[i] + 1;
+        while (*p == 'n' || *p == 'e' || *p == 'E') p++;
+        if (*p) break;
+        for (p = args[i] + 1; *p; p++) {
+            if (*p == 'n') newline = 0;
+            else if (*p == 'e') escapes = 1;
+            else escapes = 0;
+        }
+    }
+
+    for (int first = i; args[i]; i++) {
+        if (i > first) out_write(" ", 1);
+        if (escapes) {
+            if (write_escaped(args[i], 1)) return 0;   // \c: 줄바꿈 없이 끝
+        } else {
+            out_write(args[i], strlen(args[i]));
+        }
+    }
+    if (newline) out_write("\n", 1);
+    return 0;
+}
+
+// printf의 숫자 인자: 'c 형식은 문자 코드, 실패하면 경고 후 0
+static long long printf_number(const char *s, int *status) {
+    if (!s) return 0;
+    if (*s == '\'' || *s == '"') return (unsigned char)s[1];
+    char *end;
+    errno = 0;
+    long long v = strtoll(s, &end, 0);
+    if (end == s || *end || errno) {
+        err_printf("printf: %s: invalid number\n", s);
+        *status = 1;
+    }
+    return v;
+}
+
+static int builtin_printf(char **args) {
+    if (!args[1]) {
+        err_printf("printf: usage: printf format [arguments]\n");
+        return 2;
+    }
+
+    const char *fmt = args[1];
+    char **argp = args + 2;
+    int status = 0;
+
+    // 인자가 남아 있으면 형식을 처음부터 다시 사용한다
+    do {
+        int consumed = 0;
+        for (const char *p = fmt; *p; p++) {
+            if (*p == '\\') {
+                char esc[3] = { '\\', p[1], 0 };
+                if (!p[1]) { out_write("\\", 1); break; }
+                // \nnn 8진수는 여러 글자일 수 있으므로 따로 처리
+                if (p[1] >= '0' && p[1] <= '7') {
+                    char oct[5] = { '\\', 0 };
+                    int n = 1;
+                    while (n < 4 && p[n] >= '0' && p[n] <= '7') { oct[n] = p[n]; n++; }
+                    oct[n] = 0;
+                    write_escaped(oct, 0);
+                    p += n - 1;
+                    continue;
+                }
+                if (write_escaped(esc, 0)) return status;
+                p++;
+                continue;
+            }
+            if (*p != '%') {
+                const char *q = p;
+                while (q[1] && q[1] != '%' && q[1] != '\\') q++;
+                out_write(p, q - p + 1);
+                p = q;
+                continue;
+            }
+            if (p[1] == '%') { out_write("%", 1); p++; continue; }
+
+            // %[플래그][너비][.정밀도]변환
+            char spec[64];
+            size_t n = 0;
+            spec[n++] = *p++;
+            while (*p && strchr("-+ #0", *p) && n < 40) spec[n++] = *p++;
+            if (*p == '*') { n += snprintf(spec + n, 16, "%d", (int)printf_number(*argp ? *argp++ : NULL, &status)); p++; consumed = 1; }
+            else while (isdigit((unsigned char)*p) && n < 40) spec[n++] = *p++;
+            if (*p == '.') {
+                spec[n++] = *p++;
+                if (*p == '*') { n += snprintf(spec + n, 16, "%d", (int)printf_number(*argp ? *argp++ : NULL, &status)); p++; consumed = 1; }
+                else while (isdigit((unsigned char)*p) && n < 50) spec[n++] = *p++;
+            }
+            if (!*p) { out_write(spec, n); break; }
+
+            const char *arg = *argp;
+            if (arg) { argp++; consumed = 1; }
+            char conv = *p;
+
+            switch (conv) {
+                case 'd': case 'i':
+                    spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = 0;
+                    out_printf(spec, printf_number(arg, &status));
+                    break;
+                case 'u': case 'o': case 'x': case 'X':
+                    spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = 0;
+                    out_printf(spec, (unsigned long long)printf_number(arg, &status));
+                    break;
+                case 'e': case 'E': case 'f': case 'F': case 'g': case 'G':
+                    spec[n++] = conv; spec[n] = 0;
+                    out_printf(spec, arg ? strtod(arg, NULL) : 0.0);
+                    break;
+                case 'c':
+                    if (arg && *arg) out_write(arg, 1);
+                    break;
+                case 's':
+                    spec[n++] = 's'; spec[n] = 0;
+                    out_printf(spec, arg ? arg : "");
+                    break;
+                case 'b':
+                    if (arg && write_escaped(arg, 1)) return status;
+                    break;
+                default:
+                    err_printf("printf: %%%c: invalid directive\n", conv);
+                    return 1;
+            }
+        }
+        if (!consumed) break;     // 인자를 쓰지 않는 형식이면 한 번만
+    } while (*argp);
+
+    return status;
+}
+
+// ---- test / [ ----
+
+typedef struct {
+    char **argv;
+    int pos;
+    int count;
+    int error;
+} TestState;
+
+static int test_expr(TestState *t);
+
+static int is_unary_op(const char *s) {
+    return s[0] == '-' && s[1] && !s[2] && strchr("bcdefghknprsStuwxzLGO", s[1]);
+}
+
+static int is_binary_op(const char *s) {
+    static const char *ops[] = { "=", "==", "!=", "<", ">", "-eq", "-ne", "-lt", "-le",
+                                 "-gt", "-ge", "-nt", "-ot", "-ef", NULL };
+    for (int i = 0; ops[i]; i++) {
+        if (strcmp(s, ops[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int test_unary(char op, const char *arg) {
+    struct stat st;
+    switch (op) {
+        case 'z': return arg[0] == '\0';
+        case 'n': return arg[0] != '\0';
+        case 't': return isatty(atoi(arg));
+        case 'L': case 'h': return lstat(arg, &st) == 0 && S_ISLNK(st.st_mode);
+        case 'r': return access(arg, R_OK) == 0;
+        case 'w': return access(arg, W_OK) == 0;
+        case 'x': return access(arg, X_OK) == 0;
+    }
+    if (stat(arg, &st) != 0) return 0;
+    switch (op) {
+        case 'e': return 1;
+        case 'f': return S_ISREG(st.st_mode);
+        case 'd': return S_ISDIR(st.st_mode);
+        case 'b': return S_ISBLK(st.st_mode);
+        case 'c': return S_ISCHR(st.st_mode);
+        case 'p': return S_ISFIFO(st.st_mode);
+        case 'S': return S_ISSOCK(st.st_mode);
+        case 's': return st.st_size > 0;
+        case 'g': return (st.st_mode & S_ISGID) != 0;
+        case 'u': return (st.st_mode & S_ISUID) != 0;
+        case 'k': return (st.st_mode & S_ISVTX) != 0;
+        case 'O': return st.st_uid == geteuid();
+        case 'G': return st.st_gid == getegid();
+    }
+    return 0;
+}
+
+static long long test_integer(TestState *t, const char *s) {
+    char *end;
+    long long v = strtoll(s, &end, 10);
+    while (*end == ' ' || *end == '\t') end++;
+    if (end == s || *end) {
+        err_printf("test: %s: integer expression expected\n", s);
+        t->error = 1;
+    }
+    return v;
+}
+
+static int test_binary(TestState *t, const char *a, const char *op, const char *b) {
+    if (strcmp(op, "=") == 0 || strcmp(op, "==") == 0) return strcmp(a, b) == 0;
+    if (strcmp(op, "!=") == 0) return strcmp(a, b) != 0;
+    if (strcmp(op, "<") == 0) return strcmp(a, b) < 0;
+    if (strcmp(op, ">") == 0) return strcmp(a, b) > 0;
+
+    if (op[1] == 'n' || op[1] == 'o' || (op[1] == 'e' && op[2] == 'f')) {
+        struct stat sa, sb;
+        int ha = stat(a, &sa) == 0, hb = stat(b, &sb) == 0;
+        if (strcmp(op, "-ef") == 0) return ha && hb && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+        if (strcmp(op, "-nt") == 0) return ha && (!hb || sa.st_mtime > sb.st_mtime);
+        if (strcmp(op, "-ot") == 0) return hb && (!ha || sa.st_mtime < sb.st_mtime);
+    }
+
+    long long x = test_integer(t, a), y = test_integer(t, b);
+    if (strcmp(op, "-eq") == 0) return x == y;
+    if (strcmp(op, "-ne") == 0) return x != y;
+    if (strcmp(op, "-lt") == 0) return x < y;
+    if (strcmp(op, "-le") == 0) return x <= y;
+    if (strcmp(op, "-gt") == 0) return x > y;
+    return x >= y;  // -ge
+}
+
+static int test_primary(TestState *t) {
+    if (t->pos >= t->count) {
+        t->error = 1;
+        return 0;
+    }
+    char *cur = t->argv[t->pos];
+
+    // 이항 연산자가 뒤따르면 이항 비교를 우선 (예: [ -f = -f ])
+    if (t->pos + 2 < t->count && is_binary_op(t->argv[t->pos + 1])) {
+        int r = test_binary(t, cur, t->argv[t->pos + 1], t->argv[t->pos + 2]);
+        t->pos += 3;
+        return r;
+    }
+    if (strcmp(cur, "!") == 0 && t->pos + 1 < t->count) {
+        t->pos++;
+        return !test_primary(t);
+    }
+    if (strcmp(cur, "(") == 0 && t->pos + 1 < t->count) {
+        t->pos++;
+        int r = test_expr(t);
+        if (t->pos >= t->count || strcmp(t->argv[t->pos], ")") != 0) {
+            err_printf("test: missing ')'\n");
+            t->error = 1;
+            return 0;
+        }
+        t->pos++;
+        return r;
+    }
+    if (is_unary_op(cur) && t->pos + 1 < t->count) {
+        t->pos += 2;
+        return test_unary(cur[1], t->argv[t->pos - 1]);
+    }
+    t->pos++;
+    return cur[0] != '\0';   // 인자 하나: 비어 있지 않으면 참
+}
+
+static int test_and(TestState *t) {
+    int r = test_primary(t);
+    while (t->pos < t->count && strcmp(t->argv[t->pos], "-a") == 0) {
+        t->pos++;
+        int rhs = test_primary(t);
+        r = r && rhs;
+    }
+    return r;
+}
+
+static int test_expr(TestState *t) {
+    int r = test_and(t);
+    while (t->pos < t->count && strcmp(t->argv[t->pos], "-o") == 0) {
+        t->pos++;
+        int rhs = test_and(t);
+        r = r || rhs;
+    }
+    return r;
+}
+
+// 참이면 0, 거짓이면 1, 문법 오류면 2
+static int builtin_test(char **args) {
+    int count = 0;
+    while (args[count + 1]) count++;
+
+    if (strcmp(args[0], "[") == 0) {
+        if (count == 0 || strcmp(args[count], "]") != 0) {
+            err_printf("[: missing ']'\n");
+            return 2;
+        }
+        count--;
+    }
+    if (count == 0) return 1;
+
+    TestState t = { args + 1, 0, count, 0 };
+    int r = test_expr(&t);
+    if (!t.error && t.pos < t.count) {
+        err_printf("%s: too many arguments\n", args[0]);
+        t.error = 1;
+    }
+    if (t.error) return 2;
+    return r ? 0 : 1;
+}
+
+// set -o 이름 / set +o 이름 으로 켜고 끄는 쉘 옵션
+static const struct {
+    const char *name;
+    int *flag;
+} set_options[] = {
+    { "stats", &stats_enabled },
+    { NULL,    NULL }
+};
+
+static int builtin_set(char **args) {
+    if (!args[1] || (strcmp(args[1], "-o") == 0 && !args[2])) {
+        for (int i = 0; set_options[i].name; i++)
+            out_printf("%-15s %s\n", set_options[i].name, *set_options[i].flag ? "on" : "off");
+        return 0;
+    }
+    for (int i = 1; args[i]; i++) {
+        int on = strcmp(args[i], "-o") == 0;
+        if (!on && strcmp(args[i], "+o") != 0) {
+            err_printf("set: %s: invalid option\n", args[i]);
+            return 2;
+        }
+        const char *name = args[++i];
+        if (!name) {
+            err_printf("set: %s: option name required\n", args[i - 1]);
+            return 2;
+        }
+        int k = 0;
+        while (set_options[k].name && strcmp(set_options[k].name, name) != 0) k++;
+        if (!set_options[k].name) {
+            err_printf("set: %s: invalid option name\n", name);
+            return 2;
+        }
+        *set_options[k].flag = on;
+    }
+    return 0;
+}
+
+static const Builtin builtins[] = {
+    { "cd",    builtin_cd,     0 },
+    { "pwd",   builtin_pwd,    BUILTIN_PURE },
+    { "exit",  builtin_exit,   0 },
+    { "exec",  builtin_exec,   BUILTIN_KEEP_REDIRECTS },
+    { "true",  builtin_true,   BUILTIN_PURE },
+    { "false", builtin_false,  BUILTIN_PURE },
+    { "hash",  builtin_hash,   0 },
+    { "export", builtin_export, 0 },
+    { "unset", builtin_unset,  0 },
+    { ":",     builtin_colon,  BUILTIN_PURE },
+    { "echo",  builtin_echo,   BUILTIN_PURE },
+    { "printf", builtin_printf, BUILTIN_PURE },
+    { "test",  builtin_test,   BUILTIN_PURE },
+    { "[",     builtin_test,   BUILTIN_PURE },
+    { "jobs",  builtin_jobs,   0 },
+    { "wait",  builtin_wait,   0 },
+    { "fg",    builtin_fg,     0 },
+    { "bg",    builtin_bg,     0 },
+    { "set",   builtin_set,    0 },
+    { "shellstats", builtin_shellstats, 0 },
+    { NULL,    NULL,           0 }
+};
+
+const Builtin *find_builtin(const char *name) {
+    for (int i = 0; builtins[i].name; i++) {
+        if (strcmp(name, builtins[i].name) == 0) return &builtins[i];
+    }
+    return NULL;
+}
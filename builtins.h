@@ -0,0 +1,38 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <stddef.h>
+
+// 쉘 프로세스 안에서 실행되는 내장 명령어 테이블
+// 컴파일 단계에서 이름으로 한 번 찾아 두고, 실행할 때는 함수 포인터만 호출한다.
+
+typedef int (*BuiltinFn)(char **args);   // args[0]은 명령어 이름, 종료 상태 반환
+
+#define BUILTIN_PURE 0x1   // 쉘 상태를 바꾸지 않음 ($(...) 안에서 fork 없이 실행해도 됨)
+#define BUILTIN_KEEP_REDIRECTS 0x2   // 리다이렉션을 쉘에 그대로 남김 (exec 3>>log)
+
+typedef struct {
+    const char *name;
+    BuiltinFn fn;
+    int flags;
+} Builtin;
+
+const Builtin *find_builtin(const char *name);   // 없으면 NULL
+
+// 내장 명령어의 출력은 버퍼에 모았다가 write() 한 번으로 fd 1에 내보낸다.
+// fork/spawn 전, fd 1이 바뀌기 전, 프롬프트 전에는 반드시 out_flush()를 부른다.
+#define OUT_FLUSH_SIZE (64 * 1024)
+
+void out_write(const char *s, size_t len);
+void out_printf(const char *fmt, ...);
+void out_flush(void);
+void out_fd_changed(void);     // fd 1이 리다이렉션으로 바뀌었음 (터미널인지 다시 확인)
+void out_end_command(void);    // 명령어 하나가 끝남: 터미널이면 바로 내보냄
+void out_capture_begin(void);  // 이후 출력은 fd 1로 보내지 않고 모아 둠 ($(...)용)
+const char *out_capture_end(size_t *len);   // 모은 출력 (다음 출력 전까지만 유효)
+
+// 오류 메시지: 모아 둔 출력을 먼저 내보내고 stderr에 쓴다 (2>&1 일 때 순서 유지)
+void err_printf(const char *fmt, ...);
+void err_perror(const char *s);
+
+#endif // BUILTINS_H
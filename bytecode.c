@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+#include "executer.h"
+#include "vars.h"
+#include "expand.h"
+#include "timing.h"
+#include "stats.h"
+
+#define PROGRAM_INITIAL_CAP 32
+
+static int emit(Program *prog, OpCode op, Command *cmd) {
+    if (prog->count >= prog->cap) {
+        int new_cap = prog->cap ? prog->cap * 2 : PROGRAM_INITIAL_CAP;
+        Instr *code = realloc(prog->code, new_cap * sizeof(Instr));
+        if (!code) {
+            perror("compile");
+            exit(EXIT_FAILURE);
+        }
+        prog->code = code;
+        prog->cap = new_cap;
+    }
+    Instr *in = &prog->code[prog->count];
+    memset(in, 0, sizeof(Instr));
+    in->op = op;
+    in->cmd = cmd;
+    return prog->count++;
+}
+
+// 앞에서 만든 점프의 대상을 현재 위치로
+static void patch_here(Program *prog, int at) {
+    prog->code[at].arg = prog->count;
+}
+
+// 인자 첫 단어에 확장할 것이 없으면 내장 명령어를 미리 찾아 둔다
+static const Builtin *resolve_builtin(Command *cmd) {
+    if (!cmd->args || !cmd->args[0] || word_has_expansion(cmd->args[0])) return NULL;
+    return find_builtin(cmd->args[0]);
+}
+
+// 실행 중인 for 반복 하나의 상태
+typedef struct {
+    char **words;             // 반복할 값 목록 (확장이 필요하면 eb 안에 만든 사본)
+    int index;
+    ExpandBuf eb;
+} ForState;
+
+static void compile_body(Program *prog, Command *cmd);
+
+// 복합 명령어에 리다이렉션이 붙어 있으면 본문을 PUSH/POP으로 감싸서
+// 반복할 때마다가 아니라 명령어 전체에서 한 번만 연다
+static void compile_node(Program *prog, Command *cmd) {
+    if (!cmd) return;
+    if (!cmd->redirects || cmd->type == CMD_SIMPLE) {
+        compile_body(prog, cmd);
+        return;
+    }
+    int slot = prog->nsaved++;
+    int at = emit(prog, OP_REDIRECT_PUSH, cmd);
+    prog->code[at].slot = slot;
+    compile_body(prog, cmd);
+    patch_here(prog, at);                   // 적용에 실패하면 본문을 건너뛰고 되돌리기만
+    at = emit(prog, OP_REDIRECT_POP, NULL);
+    prog->code[at].slot = slot;
+}
+
+static void compile_body(Program *prog, Command *cmd) {
+    int at, jump_end;
+
+    switch (cmd->type) {
+        case CMD_SIMPLE:
+            at = emit(prog, OP_SIMPLE, cmd);
+            prog->code[at].builtin = resolve_builtin(cmd);
+            break;
+
+        case CMD_PIPE:
+            emit(prog, OP_PIPELINE, cmd);
+            break;
+
+        case CMD_SEQUENCE:
+            compile_node(prog, cmd->left);
+            compile_node(prog, cmd->right);
+            break;
+
+        case CMD_AND:       // left가 실패하면 right를 건너뜀
+            compile_node(prog, cmd->left);
+            at = emit(prog, OP_JUMP_IF_FAIL, NULL);
+            compile_node(prog, cmd->right);
+            patch_here(prog, at);
+            break;
+
+        case CMD_OR:        // left가 성공하면 right를 건너뜀
+            compile_node(prog, cmd->left);
+            at = emit(prog, OP_JUMP_IF_OK, NULL);
+            compile_node(prog, cmd->right);
+            patch_here(prog, at);
+            break;
+
+        case CMD_IF:
+            compile_node(prog, cmd->condition);
+            at = emit(prog, OP_JUMP_IF_FAIL, NULL);
+            compile_node(prog, cmd->then_block);
+            jump_end = emit(prog, OP_JUMP, NULL);
+            patch_here(prog, at);
+            if (cmd->else_block) {
+                compile_node(prog, cmd->else_block);
+            } else {
+                emit(prog, OP_STATUS, NULL);   // 실행된 분기가 없으면 상태 0
+            }
+            patch_here(prog, jump_end);
+            break;
+
+        case CMD_WHILE: {
+            int top = prog->count;
+            compile_node(prog, cmd->condition);
+            at = emit(prog, OP_JUMP_IF_FAIL, NULL);
+            compile_node(prog, cmd->then_block);
+            jump_end = emit(prog, OP_JUMP, NULL);   // 조건으로 되돌아감
+            prog->code[jump_end].arg = top;
+            patch_here(prog, at);
+            emit(prog, OP_STATUS, NULL);       // 조건 실패로 끝난 반복은 상태 0
+            break;
+        }
+
+        case CMD_FOR: {
+            if (cmd->parallel > 0) {
+                emit(prog, OP_FOR_PARALLEL, cmd);
+                break;
+            }
+            int slot = prog->nslots++;
+            at = emit(prog, OP_FOR_INIT, cmd);
+            prog->code[at].slot = slot;
+            int top = emit(prog, OP_FOR_NEXT, cmd);
+            prog->code[top].slot = slot;
+            compile_node(prog, cmd->then_block);
+            jump_end = emit(prog, OP_JUMP, NULL);   // 다음 값으로 되돌아감
+            prog->code[jump_end].arg = top;
+            patch_here(prog, top);
+            break;
+        }
+
+        case CMD_BACKGROUND:
+            emit(prog, OP_BACKGROUND, cmd->left);
+            compile_node(prog, cmd->right);
+            break;
+
+        case CMD_GROUP:
+            compile_node(prog, cmd->left);
+            break;
+
+        case CMD_SUBSHELL:
+            emit(prog, OP_SUBSHELL, cmd->left);
+            break;
+
+        case CMD_TIME:
+            emit(prog, OP_TIME_BEGIN, cmd->left);
+            if (cmd->left) compile_node(prog, cmd->left);
+            else emit(prog, OP_STATUS, NULL);
+            emit(prog, OP_TIME_END, NULL);
+            break;
+
+        default:
+            fprintf(stderr, "Unknown command type\n");
+            break;
+    }
+}
+
+void compile_command(Program *prog, Command *cmd) {
+    compile_node(prog, cmd);
+    emit(prog, OP_END, NULL);
+}
+
+int run_program(Program *prog) {
+    ForState *loops = prog->nslots ? calloc(prog->nslots, sizeof(ForState)) : NULL;
+    SavedFds *saved = prog->nsaved ? calloc(prog->nsaved, sizeof(SavedFds)) : NULL;
+    int status = 0;
+    int pc = 0;
+
+    while (1) {
+        Instr *in = &prog->code[pc++];
+
+        switch (in->op) {
+            case OP_SIMPLE:
+                status = last_status = execute_simple(in->cmd, in->builtin);
+                break;
+
+            case OP_PIPELINE:
+                status = last_status = execute_pipeline(in->cmd);
+                break;
+
+            case OP_BACKGROUND:
+                status = last_status = execute_background(in->cmd);
+                break;
+
+            case OP_SUBSHELL:
+                status = last_status = execute_subshell(in->cmd);
+                break;
+
+            case OP_FOR_PARALLEL:
+                status = last_status = execute_parallel_for(in->cmd);
+                break;
+
+            case OP_TIME_BEGIN:
+                timing_begin(in->cmd);
+                break;
+
+            case OP_TIME_END:
+                timing_end();
+                break;
+
+            case OP_REDIRECT_PUSH:
+                if (redirect_push_command(in->cmd, &saved[in->slot]) < 0) {
+                    status = last_status = 1;
+                    pc = in->arg;
+                }
+                break;
+
+            case OP_REDIRECT_POP:
+                redirect_pop(&saved[in->slot]);
+                break;
+
+            case OP_STATUS:
+                status = last_status = in->arg;
+                break;
+
+            case OP_JUMP:
+                pc = in->arg;
+                break;
+
+            case OP_JUMP_IF_OK:
+                if (status == 0) pc = in->arg;
+                break;
+
+            case OP_JUMP_IF_FAIL:
+                if (status != 0) pc = in->arg;
+                break;
+
+            case OP_FOR_INIT: {
+                ForState *loop = &loops[in->slot];
+                // args[0]은 변수 이름, 값은 args[1]부터. 목록은 반복을 시작할 때 한 번만 확장
+                loop->words = in->cmd->args + 1;
+                if (in->cmd->expand) {
+                    STATS_BEGIN(t0);
+                    loop->words = expand_words(&loop->eb, in->cmd->args + 1);
+                    STATS_END(STAT_EXPAND, t0);
+                }
+                loop->index = 0;
+                status = last_status = 0;
+                if (!loop->words) {        // 확장 실패: 반복하지 않음
+                    static char *no_words[] = { NULL };
+                    loop->words = no_words;
+                    status = last_status = 1;
+                }
+                break;
+            }
+
+            case OP_FOR_NEXT: {
+                ForState *loop = &loops[in->slot];
+                char *value = loop->words[loop->index];
+                if (!value) {
+                    pc = in->arg;
+                    break;
+                }
+                loop->index++;
+                var_set(in->cmd->args[0], value, 0);   // 같은 슬롯을 덮어씀 (할당 없음)
+                break;
+            }
+
+            case OP_END:
+                for (int i = 0; i < prog->nslots; i++) expand_buf_free(&loops[i].eb);
+                free(loops);
+                free(saved);
+                return status;
+        }
+    }
+}
+
+void free_program(Program *prog) {
+    free(prog->code);
+    prog->code = NULL;
+    prog->count = prog->cap = prog->nslots = prog->nsaved = 0;
+}
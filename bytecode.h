@@ -0,0 +1,49 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "parser.h"
+#include "builtins.h"
+
+// Command 트리를 평평한 명령어 배열로 컴파일하고, 재귀 없는 루프로 실행한다.
+// &&, ||, if, while, for는 모두 점프로 바뀌고 내장 명령어는 컴파일할 때 미리 찾아 둔다.
+
+typedef enum {
+    OP_SIMPLE,        // 단순 명령어 실행 (builtin이 있으면 직접 호출)
+    OP_PIPELINE,      // 파이프라인 실행
+    OP_BACKGROUND,    // 백그라운드 실행 (상태 0)
+    OP_SUBSHELL,      // 자식 프로세스에서 실행 후 대기
+    OP_STATUS,        // status = arg
+    OP_JUMP,          // 무조건 arg로 점프
+    OP_JUMP_IF_OK,    // status == 0 이면 arg로 점프
+    OP_JUMP_IF_FAIL,  // status != 0 이면 arg로 점프
+    OP_FOR_INIT,      // 반복 슬롯 slot의 인덱스를 처음으로
+    OP_FOR_NEXT,      // 다음 값을 변수에 넣고, 값이 없으면 arg로 점프
+    OP_FOR_PARALLEL,  // for -j N: 반복 전체를 자식 프로세스들에서 실행
+    OP_TIME_BEGIN,    // time: 시간과 자원 사용량 재기 시작
+    OP_TIME_END,      // time: 결과 출력 (status는 그대로)
+    OP_REDIRECT_PUSH, // 복합 명령어의 리다이렉션 적용 (fd는 slot에 보관). 실패하면 status 1로 arg로 점프
+    OP_REDIRECT_POP,  // slot에 보관한 fd 복원 (status는 그대로)
+    OP_END
+} OpCode;
+
+typedef struct {
+    OpCode op;
+    int arg;                  // 점프 대상 또는 상태 값
+    int slot;                 // for 반복 슬롯 번호, 리다이렉션 슬롯 번호
+    Command *cmd;             // 실행할 노드
+    const Builtin *builtin;   // OP_SIMPLE: 미리 찾아 둔 내장 명령어
+} Instr;
+
+typedef struct {
+    Instr *code;
+    int count;
+    int cap;
+    int nslots;               // for 반복 슬롯 개수 (중첩된 for마다 하나)
+    int nsaved;               // 리다이렉션 슬롯 개수 (리다이렉션이 붙은 복합 명령어마다 하나)
+} Program;
+
+void compile_command(Program *prog, Command *cmd);   // prog 뒤에 cmd를 이어서 컴파일 (OP_END 포함)
+int run_program(Program *prog);                      // 마지막 명령어의 종료 상태 반환
+void free_program(Program *prog);
+
+#endif // BYTECODE_H
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cmdhash.h"
+#include "builtins.h"
+#include "vars.h"
+
+typedef struct {
+    char *name;         // 명령어 이름 (NULL이면 빈 슬롯)
+    char *path;         // 찾은 절대 경로 (NULL이면 "없음"으로 캐시된 항목)
+    unsigned hits;      // 사용 횟수 (hash 출력용)
+    unsigned gen;       // "없음"을 확인했을 때의 dir_gen
+} HashEntry;
+
+static HashEntry *table = NULL;
+static size_t table_size = 0;      // 항상 2의 거듭제곱
+static size_t table_used = 0;
+static char *cached_path = NULL;   // 테이블을 채울 때 사용한 PATH 값
+static struct timespec *dir_mtimes = NULL;   // cached_path의 디렉터리별 mtime (없는 디렉터리는 0)
+static size_t dir_count = 0;
+static unsigned dir_gen = 0;       // PATH 디렉터리의 mtime이 바뀔 때마다 증가
+
+static unsigned long hash_name(const char *s) {
+    unsigned long h = 5381;        // djb2
+    while (*s) h = h * 33 + (unsigned char)*s++;
+    return h;
+}
+
+void cmdhash_clear(void) {
+    for (size_t i = 0; i < table_size; i++) {
+        free(table[i].name);
+        free(table[i].path);
+    }
+    free(table);
+    table = NULL;
+    table_size = table_used = 0;
+    free(cached_path);
+    cached_path = NULL;
+    free(dir_mtimes);
+    dir_mtimes = NULL;
+    dir_count = 0;
+}
+
+// 선형 탐사로 name의 슬롯을 찾는다 (없으면 비어 있는 슬롯)
+static HashEntry *find_slot(HashEntry *tab, size_t size, const char *name) {
+    size_t i = hash_name(name) & (size - 1);
+    while (tab[i].name && strcmp(tab[i].name, name) != 0)
+        i = (i + 1) & (size - 1);
+    return &tab[i];
+}
+
+static void grow_table(void) {
+    size_t new_size = table_size ? table_size * 2 : CMDHASH_INITIAL_SIZE;
+    HashEntry *new_tab = calloc(new_size, sizeof(HashEntry));
+    if (!new_tab) return;
+
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].name)
+            *find_slot(new_tab, new_size, table[i].name) = table[i];
+    }
+    free(table);
+    table = new_tab;
+    table_size = new_size;
+}
+
+// PATH 디렉터리들의 mtime을 다시 읽어 dir_mtimes에 저장한다. 하나라도 바뀌었으면 1
+// (디렉터리에 파일이 생기거나 지워지면 mtime이 바뀌므로, 새로 설치된 명령어를 알 수 있다)
+static int dir_mtimes_changed(void) {
+    int changed = 0;
+    const char *dir = cached_path;
+    for (size_t i = 0; i < dir_count; i++) {
+        const char *end = strchr(dir, ':');
+        size_t dir_len = end ? (size_t)(end - dir) : strlen(dir);
+        char name[4096];
+        struct stat st;
+        struct timespec mtime = { 0, 0 };
+
+        if (dir_len == 0) strcpy(name, ".");          // 빈 항목은 현재 디렉터리
+        else snprintf(name, sizeof(name), "%.*s", (int)dir_len, dir);
+        if (stat(name, &st) == 0) mtime = st.st_mtim;
+        if (mtime.tv_sec != dir_mtimes[i].tv_sec || mtime.tv_nsec != dir_mtimes[i].tv_nsec) {
+            dir_mtimes[i] = mtime;
+            changed = 1;
+        }
+        if (end) dir = end + 1;
+    }
+    return changed;
+}
+
+// PATH가 마지막으로 채울 때와 달라졌으면 캐시를 버린다
+static void check_path_changed(const char *path) {
+    if (cached_path && strcmp(cached_path, path) == 0) return;
+    cmdhash_clear();
+    cached_path = strdup(path);
+    if (!cached_path) return;
+
+    size_t count = 1;
+    for (const char *p = cached_path; *p; p++)
+        if (*p == ':') count++;
+    dir_mtimes = calloc(count, sizeof(struct timespec));
+    if (!dir_mtimes) return;
+    dir_count = count;
+    dir_mtimes_changed();
+}
+
+// PATH의 각 디렉터리에서 실행 가능한 일반 파일을 찾는다
+static char *search_path(const char *name, const char *path) {
+    size_t name_len = strlen(name);
+    const char *dir = path;
+
+    while (1) {
+        const char *end = strchr(dir, ':');
+        size_t dir_len = end ? (size_t)(end - dir) : strlen(dir);
+
+        char *full = malloc(dir_len + name_len + 3);
+        if (!full) return NULL;
+        if (dir_len == 0) {
+            strcpy(full, "./");              // 빈 항목은 현재 디렉터리
+        } else {
+            memcpy(full, dir, dir_len);
+            full[dir_len] = '/';
+            full[dir_len + 1] = '\0';
+        }
+        strcat(full, name);
+
+        struct stat st;
+        if (stat(full, &st) == 0 && S_ISREG(st.st_mode) && access(full, X_OK) == 0)
+            return full;
+        free(full);
+
+        if (!end) break;
+        dir = end + 1;
+    }
+    return NULL;
+}
+
+// 테이블에 없으면 PATH에서 찾아 넣는다. 찾지 못한 이름도 path == NULL로 넣어 둔다.
+// "없음" 항목은 PATH 디렉터리의 mtime이 바뀌었을 때만 다시 찾는다 (디렉터리 stat만 하면 됨).
+static HashEntry *hash_insert(const char *name) {
+    if ((table_used + 1) * 2 > table_size) grow_table();
+    if (!table) return NULL;
+
+    HashEntry *e = find_slot(table, table_size, name);
+    if (!e->name) {
+        e->name = strdup(name);
+        e->path = search_path(name, cached_path);
+        e->hits = 0;
+        e->gen = dir_gen;
+        table_used++;
+    } else if (!e->path) {
+        if (dir_mtimes_changed()) dir_gen++;
+        if (e->gen != dir_gen) {
+            e->path = search_path(name, cached_path);
+            e->gen = dir_gen;
+        }
+    }
+    return e;
+}
+
+const char *cmdhash_lookup(const char *name) {
+    if (strchr(name, '/')) return name;   // 경로가 주어지면 검색하지 않음
+
+    const char *path = var_get("PATH");
+    if (!path) path = "/usr/local/bin:/usr/bin:/bin";
+    check_path_changed(path);
+
+    HashEntry *e = hash_insert(name);
+    if (!e || !e->path) return NULL;
+    e->hits++;
+    return e->path;
+}
+
+int builtin_hash(char **args) {
+    // hash -r : 테이블 비우기
+    if (args[1] && strcmp(args[1], "-r") == 0) {
+        cmdhash_clear();
+        return 0;
+    }
+
+    // hash name... : 미리 채우기
+    if (args[1]) {
+        int status = 0;
+        const char *path = var_get("PATH");
+        if (!path) path = "/usr/local/bin:/usr/bin:/bin";
+        check_path_changed(path);
+
+        for (int i = 1; args[i]; i++) {
+            if (strchr(args[i], '/')) continue;
+            HashEntry *e = hash_insert(args[i]);
+            if (!e || !e->path) {
+                err_printf("hash: %s: not found\n", args[i]);
+                status = 1;
+            }
+        }
+        return status;
+    }
+
+    // hash : 현재 테이블 출력
+    if (table_used == 0) {
+        out_printf("hash: hash table empty\n");
+        return 0;
+    }
+    out_printf("hits\tcommand\n");
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].name && table[i].path)
+            out_printf("%4u\t%s\n", table[i].hits, table[i].path);
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef CMDHASH_H
+#define CMDHASH_H
+
+// 외부 명령어의 절대 경로를 기억해 두는 해시 테이블 (bash의 hash와 같은 역할)
+// PATH가 바뀌면 테이블 전체를 비우고, 찾지 못한 명령어도 음성 캐시로 기억한다.
+// 음성 항목은 PATH 디렉터리의 mtime이 바뀌면 (명령어가 새로 설치되면) 다시 찾는다.
+
+#define CMDHASH_INITIAL_SIZE 64
+
+const char *cmdhash_lookup(const char *name);   // 절대 경로 반환, 없으면 NULL
+void cmdhash_clear(void);                       // 테이블 비우기 (hash -r)
+int builtin_hash(char **args);                  // hash 내장 명령어
+
+#endif // CMDHASH_H
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE   // pipe2(), memfd_create()
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,293 +8,615 @@
 #include "parser.h"
 #include "tokenizer.h"
 #include "executer.h"
+#include "cmdhash.h"
+#include "spawn.h"
+#include "builtins.h"
+#include "bytecode.h"
+#include "vars.h"
+#include "expand.h"
+#include "jobs.h"
+#include "timing.h"
+#include "stats.h"
 #include <ctype.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <signal.h>
+
+extern char **environ;
+
+int shell_argc = 0;          // 위치 매개변수 개수 ($0 포함)
+char **shell_argv = NULL;    // $0, $1, ... (스크립트 모드에서는 스크립트 경로와 인자)
+int last_status = 0;
+pid_t shell_pid = 0;
+pid_t last_bg_pid = 0;
 
 void execute_command(Command *cmd);
 int execute_and_get_status(Command *cmd);
 
-void apply_redirection(Redirect *redir) {
-    for (; redir; redir = redir->next) {
-        const char *op = redir->op;
-        const char *file = redir->file;
-        int target_fd = STDOUT_FILENO;  // 기본은 STDOUT
-        int fd;
+// 모두 써질 때까지 write (EINTR, 부분 쓰기 처리)
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
 
-        // 1. 앞에 FD가 붙어있으면 추출 (예: 2>, 3>>)
-        const char *p = op;
-        while (isdigit(*p)) p++;
-        if (p != op) {
-            char fd_buf[8] = {0};
-            strncpy(fd_buf, op, p - op);
-            target_fd = atoi(fd_buf);  // 예: "2>" → 2
+// heredoc 본문을 읽을 수 있는 fd를 만든다. 본문은 memfd에 한 번 써서 되감으므로
+// 크기 제한도, 임시 파일도, 쓰는 쪽 프로세스도 필요 없다.
+// memfd를 쓸 수 없으면 파이프: 파이프 버퍼에 다 들어가면 바로 쓰고, 아니면 손자 프로세스가 쓴다.
+static int open_heredoc(Redirect *redir) {
+    ExpandBuf *eb = expand_acquire();
+    if (!eb) return -1;
+    size_t len;
+    const char *body = expand_heredoc(eb, redir, &len);
+    int fd = -1;
+    if (!body) goto out;
+
+    fd = memfd_create("heredoc", MFD_CLOEXEC);
+    if (fd >= 0) {
+        if (write_all(fd, body, len) < 0 || lseek(fd, 0, SEEK_SET) < 0) {
+            perror("heredoc");
+            close(fd);
+            fd = -1;
         }
+        goto out;
+    }
 
-        // 2. 리다이렉션 종류 확인
-        if (strcmp(p, ">") == 0) {
-            fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-            if (fd < 0) { perror("open >"); continue; }
-            dup2(fd, target_fd);
-            close(fd);
-        } else if (strcmp(p, ">>") == 0) {
-            fd = open(file, O_WRONLY | O_CREAT | O_APPEND, 0644);
-            if (fd < 0) { perror("open >>"); continue; }
-            dup2(fd, target_fd);
-            close(fd);
-        } else if (strcmp(p, "<") == 0) {
-            fd = open(file, O_RDONLY);
-            if (fd < 0) { perror("open <"); continue; }
-            dup2(fd, target_fd);
-            close(fd);
-        } else if (strcmp(p, "<>") == 0) {
-            fd = open(file, O_RDWR | O_CREAT, 0644);
-            if (fd < 0) { perror("open <>"); continue; }
-            dup2(fd, target_fd);
-            close(fd);
-        } else if (strcmp(p, ">&") == 0) {
-            // file은 fd 문자열이어야 함 (예: 2>&1)
-            int dest_fd = atoi(file);
-            dup2(dest_fd, target_fd);
-        } else if (strcmp(p, "<&-") == 0 || strcmp(p, ">&-") == 0) {
-            // FD 닫기 (예: 2>&-)
-            close(target_fd);
-        } else if (strcmp(p, "&>") == 0) {
-            // STDOUT, STDERR 모두 같은 파일로
-            fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-            if (fd < 0) { perror("open &>"); continue; }
-            dup2(fd, STDOUT_FILENO);
-            dup2(fd, STDERR_FILENO);
-            close(fd);
-        } else if (strcmp(p, "&>>") == 0) {
-            fd = open(file, O_WRONLY | O_CREAT | O_APPEND, 0644);
-            if (fd < 0) { perror("open &>>"); continue; }
-            dup2(fd, STDOUT_FILENO);
-            dup2(fd, STDERR_FILENO);
-            close(fd);
-        } else {
-            fprintf(stderr, "[!] Unsupported redirection: %s\n", op);
+    int p[2];
+    if (pipe2(p, O_CLOEXEC) < 0) {
+        perror("heredoc");
+        goto out;
+    }
+    if (len <= HEREDOC_PIPE_SIZE) {
+        write_all(p[1], body, len);
+    } else {
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (fork() == 0) {      // 손자가 쓰고, 자식은 바로 끝나서 좀비가 남지 않음
+                close(p[0]);
+                _exit(write_all(p[1], body, len) < 0);
+            }
+            _exit(0);
         }
+        if (pid > 0) waitpid(pid, NULL, 0);
+        else perror("fork");
     }
+    close(p[1]);
+    fd = p[0];
+out:
+    expand_release();
+    return fd;
 }
 
+// fd를 target 번호로 옮긴다. 이미 그 번호면 exec 때 닫히지 않도록 CLOEXEC만 끈다
+static void move_fd(int fd, int target) {
+    if (fd == target) {
+        fcntl(fd, F_SETFD, 0);
+        return;
+    }
+    dup2(fd, target);
+    close(fd);
+}
 
+// 리다이렉션을 현재 프로세스에 적용. 파일을 열 수 없으면 -1
+// 연산자는 파싱할 때 해석해 두었으므로 기록대로 시스템 콜만 한다.
+int apply_redirection(Redirect *redir) {
+    int result = 0;
+    for (; redir; redir = redir->next) {
+        int fd;
+        switch (redir->kind) {
+            case REDIR_OPEN:
+                fd = open(redir->file, redir->flags, 0644);
+                if (fd < 0) { err_perror(redir->file); result = -1; continue; }
+                if (redir->target_fd >= 0 && redir->target_fd != fd) dup2(fd, redir->target_fd);   // &>
+                move_fd(fd, redir->fd);
+                break;
+            case REDIR_DUP:
+                if (dup2(redir->target_fd, redir->fd) < 0) {
+                    err_printf("%d: %s\n", redir->target_fd, strerror(errno));
+                    result = -1;
+                }
+                break;
+            case REDIR_CLOSE:
+                close(redir->fd);
+                break;
+            case REDIR_HEREDOC:
+                fd = open_heredoc(redir);
+                if (fd < 0) { result = -1; continue; }
+                move_fd(fd, redir->fd);
+                break;
+            default:
+                fprintf(stderr, "[!] Unsupported redirection: %s\n", redir->op);
+                result = -1;
+                break;
+        }
+    }
+    return result;
+}
 
-void execute_pipeline(Command *cmd) {
-    int pipefd[2];
-    int in_fd = 0;  // stdin
-    pid_t pid;
-
-    while (cmd && cmd->type == CMD_PIPE) {
-        pipe(pipefd);
+// 리다이렉션이 건드리는 fd 목록 (&>, &>>는 1과 2 둘 다)
+static int redirect_targets(Redirect *redir, int *fds) {
+    fds[0] = redir->fd;
+    if (redir->kind == REDIR_OPEN && redir->target_fd >= 0) {
+        fds[1] = redir->target_fd;
+        return 2;
+    }
+    return 1;
+}
 
-        if ((pid = fork()) == 0) {
-            dup2(in_fd, 0);            // 이전 파이프의 읽기 쪽을 stdin으로
-            dup2(pipefd[1], 1);        // pipe 출력 -> stdout
-            close(pipefd[0]);          // 읽기 끝 닫기
-            execute_command(cmd->left);
-            exit(0);
-        } else {
-            waitpid(pid, NULL, 0);
-            close(pipefd[1]);          // 쓰기 끝 닫기
-            in_fd = pipefd[0];         // 다음 명령어는 이걸 stdin으로 씀
-            cmd = cmd->right;
+// 쉘 프로세스 안에서 리다이렉션을 적용하기 전에 바뀔 fd를 복제해 둔다.
+// 실패해도 saved는 항상 redirect_pop()으로 되돌려야 한다.
+int redirect_push(Redirect *redir, SavedFds *saved) {
+    saved->count = 0;
+    out_flush();   // 버퍼에 남은 출력은 원래 fd 1로 나가야 함
+
+    for (Redirect *r = redir; r; r = r->next) {
+        int fds[2];
+        int n = redirect_targets(r, fds);
+        for (int i = 0; i < n; i++) {
+            int dup_of = 0;
+            for (int j = 0; j < saved->count; j++) {
+                if (saved->fd[j] == fds[i]) dup_of = 1;
+            }
+            if (dup_of || saved->count >= MAX_SAVED_FDS) continue;
+            saved->fd[saved->count] = fds[i];
+            // 닫혀 있던 fd는 -1로 기록 → 복원할 때 다시 닫음
+            saved->copy[saved->count] = fcntl(fds[i], F_DUPFD_CLOEXEC, SAVED_FD_BASE);
+            saved->count++;
         }
     }
 
-    if (cmd) {
-        if ((pid = fork()) == 0) {
-            dup2(in_fd, 0);
-            execute_command(cmd);
-            exit(0);
+    int result = apply_redirection(redir);
+    out_fd_changed();
+    return result;
+}
+
+// 복합 명령어 (done > $log, } 2>&1 ...) 의 리다이렉션. 파일 이름은 적용할 때 한 번만 확장한다
+int redirect_push_command(Command *cmd, SavedFds *saved) {
+    int expand = 0;
+    for (Redirect *r = cmd->redirects; r; r = r->next) {
+        if (word_has_expansion(r->file)) expand = 1;
+    }
+    if (!expand) return redirect_push(cmd->redirects, saved);
+
+    saved->count = 0;
+    ExpandBuf *eb = expand_acquire();
+    if (!eb) return -1;
+    Command bare = *cmd, expanded;
+    bare.args = NULL;                       // 복합 명령어의 args (for 목록)는 여기서 확장하지 않음
+    int result = -1;
+    if (expand_command(&bare, &expanded, eb) == 0) result = redirect_push(expanded.redirects, saved);
+    expand_release();
+    return result;
+}
+
+void redirect_pop(SavedFds *saved) {
+    out_flush();   // 리다이렉션된 곳으로 보낼 출력을 먼저 내보냄
+    for (int i = saved->count - 1; i >= 0; i--) {
+        if (saved->copy[i] >= 0) {
+            dup2(saved->copy[i], saved->fd[i]);
+            close(saved->copy[i]);
         } else {
-            waitpid(pid, NULL, 0);
+            close(saved->fd[i]);
         }
     }
+    saved->count = 0;
+    out_fd_changed();
 }
 
 
-int execute_and_get_status(Command *cmd) {
-    if (!cmd) return 1;
 
-    if (cmd->type == CMD_SIMPLE) {
-        if (!cmd->args[0]) return 1;
+// 외부 명령어로 실행할 단순 명령어면 경로를 반환 (spawn 경로 후보)
+// 확장이 필요한 명령어는 자식에서 확장하도록 fork 경로로 보낸다
+static const char *external_path(Command *cmd) {
+    if (!cmd || cmd->type != CMD_SIMPLE || cmd->expand || !cmd->args[0] || find_builtin(cmd->args[0]))
+        return NULL;
+    return cmdhash_lookup(cmd->args[0]);
+}
 
-        //내부 명령어 cd, pwd 수행
-        if (strcmp(cmd->args[0], "cd") == 0) {
-    const char *path = cmd->args[1];
-    
-    if (!path) {
-        // case: cd
-        path = getenv("HOME");
-    } else if (strcmp(path, "~") == 0) {
-        // case: cd ~
-        path = getenv("HOME");
-    } else if (strcmp(path, "-") == 0) {
-        // case: cd -
-        path = getenv("OLDPWD");
-        if (path)
-            printf("%s\n", path); // cd -는 이동 경로 출력해야 함
-    } else if (path[0] == '~') {
-        // case: cd ~/something
-        const char *home = getenv("HOME");
-        if (home) {
-            static char expanded[1024];
-            snprintf(expanded, sizeof(expanded), "%s%s", home, path + 1); // '~' 이후 경로 붙이기
-            path = expanded;
-        }
+// PIPE 트리(왼쪽으로 누적됨)를 실행 순서대로 펼쳐 단계 배열에 담는다
+static int collect_pipeline_stages(Command *cmd, Command **stages, int n) {
+    if (cmd && cmd->type == CMD_PIPE && n < MAX_PIPELINE_STAGES - 1) {
+        n = collect_pipeline_stages(cmd->left, stages, n);
+        return collect_pipeline_stages(cmd->right, stages, n);
     }
+    if (cmd && n < MAX_PIPELINE_STAGES) stages[n++] = cmd;
+    return n;
+}
 
-    if (chdir(path) != 0) {
-        perror("cd");
-        return 1;
-    }
+int execute_pipeline(Command *cmd) {
+    Command *stages[MAX_PIPELINE_STAGES];
+    pid_t pids[MAX_PIPELINE_STAGES];
+    int stage_of[MAX_PIPELINE_STAGES];   // pids[i]가 몇 번째 단계인지
+    int nstages = collect_pipeline_stages(cmd, stages, 0);
+    int nforked = 0;
+    int pipefd[2];
+    int in_fd = STDIN_FILENO;  // 첫 단계는 쉘의 stdin을 그대로 사용
 
-    // OLDPWD 업데이트
-    setenv("OLDPWD", getenv("PWD"), 1);
-    char cwd[1024];
-    if (getcwd(cwd, sizeof(cwd)))
-        setenv("PWD", cwd, 1);
+    out_flush();  // 버퍼에 남은 출력이 자식 프로세스로 복제되지 않도록
 
-    return 0;
-}
+    // 1. 모든 단계를 먼저 fork → 각 단계가 동시에 실행됨
+    for (int i = 0; i < nstages; i++) {
+        int last = (i == nstages - 1);
+        pipefd[0] = pipefd[1] = -1;
+        if (!last && pipe2(pipefd, O_CLOEXEC) < 0) {  // exec/spawn된 자식에는 새지 않도록
+            perror("pipe");
+            break;
+        }
 
-    if (strcmp(cmd->args[0], "pwd") == 0) {
-    int use_physical = 0; // -P 옵션 여부
+        // 외부 명령어 단계는 posix_spawn으로, 나머지는 fork로 실행
+        pid_t pid = SPAWN_FALLBACK;
+        const char *path = external_path(stages[i]);
+        STATS_BEGIN(t0);
+        if (path) pid = spawn_command(stages[i], path, in_fd, last ? -1 : pipefd[1], 0);
+        if (pid == SPAWN_FALLBACK) {
+            pid = fork();
+            if (pid < 0) perror("fork");
+        }
+        if (pid > 0 && stats_enabled) {
+            uint64_t t1 = stats_now();
+            stats_record(STAT_SPAWN, t1 - t0);
+            stats_child_started(pid, t1);
+        }
 
-    // 옵션 파싱
-    if (cmd->args[1]) {
-        if (strcmp(cmd->args[1], "-P") == 0) {
-            use_physical = 1;
-        } else if (strcmp(cmd->args[1], "-L") != 0) {
-            fprintf(stderr, "pwd: invalid option -- '%s'\n", cmd->args[1]);
-            return 1;
+        if (pid == 0) {
+            if (in_fd != STDIN_FILENO) {
+                dup2(in_fd, STDIN_FILENO);  // 이전 파이프의 읽기 쪽을 stdin으로
+                close(in_fd);
+            }
+            if (!last) {
+                dup2(pipefd[1], STDOUT_FILENO); // pipe 출력 -> stdout
+                close(pipefd[0]);               // 읽기 끝 닫기
+                close(pipefd[1]);
+                out_fd_changed();
+            }
+            int status = execute_and_get_status(stages[i]);
+            out_flush();
+            _exit(status);
+        }
+        if (pid > 0) {
+            stage_of[nforked] = i;
+            pids[nforked++] = pid;
         }
+
+        // 부모는 파이프 끝을 들고 있지 않아야 EOF가 정상 전달됨
+        if (in_fd != STDIN_FILENO) close(in_fd);
+        if (!last) close(pipefd[1]);
+        in_fd = pipefd[0];  // 다음 명령어는 이걸 stdin으로 씀
     }
+    if (in_fd > STDIN_FILENO) close(in_fd);
 
-    if (use_physical) {
-        char real[1024];
-        if (getcwd(real, sizeof(real)))
-            printf("%s\n", real);
-        else
-            perror("pwd");
-    } else {
-        // 논리 경로: PWD 환경변수 사용
-        const char *pwd = getenv("PWD");
-        if (pwd && *pwd)
-            printf("%s\n", pwd);
-        else {
-            // Fallback
-            char cwd[1024];
-            if (getcwd(cwd, sizeof(cwd)))
-                printf("%s\n", cwd);
-            else
-                perror("pwd");
+    // 2. 모든 단계를 시작한 뒤에 한꺼번에 회수 (time의 대상이면 단계별 사용량도)
+    struct rusage *usage = timing_stage_usage(cmd, stages, nstages);
+    int status = 0;
+    for (int i = 0; i < nforked; i++) {
+        wait_child(pids[i], &status, usage ? &usage[stage_of[i]] : NULL);
+    }
+    // 파이프라인의 종료 상태는 마지막 단계의 상태
+    return (nforked == nstages && WIFEXITED(status)) ? WEXITSTATUS(status) : 1;
+}
+
+
+// NAME=value 형태의 단어면 이름 길이, 아니면 0
+static size_t assignment_name_len(const char *word) {
+    const char *eq = strchr(word, '=');
+    if (!eq || !var_valid_name(word, eq - word)) return 0;
+    return eq - word;
+}
+
+static int run_simple(Command *cmd, const Builtin *builtin);
+
+// 인자와 리다이렉션 파일 이름을 확장한 사본으로 실행 (버퍼는 중첩 깊이마다 재사용)
+int execute_simple(Command *cmd, const Builtin *builtin) {
+    expand_reset_status();
+    if (!cmd->expand) return run_simple(cmd, builtin);
+
+    ExpandBuf *eb = expand_acquire();
+    if (!eb) return 1;
+    Command expanded;
+    int status = 1;
+    STATS_BEGIN(t0);
+    int failed = expand_command(cmd, &expanded, eb) < 0;
+    STATS_END(STAT_EXPAND, t0);
+    if (!failed) {
+        if (!expanded.args[0]) {
+            // 확장 결과 빈 명령어 (예: $empty, $(true))
+            status = expand_subst_status >= 0 ? expand_subst_status : 0;
+        } else {
+            status = run_simple(&expanded, find_builtin(expanded.args[0]));
         }
     }
-    return 0;
+    expand_release();
+    return status;
 }
 
-        if (strcmp(cmd->args[0], "true") == 0) return 0;
-        if (strcmp(cmd->args[0], "false") == 0) return 1;
+static int run_simple(Command *cmd, const Builtin *builtin) {
+    if (!cmd->args[0]) return 1;
 
-        //외부 명령어 수행
-        pid_t pid = fork();
-        if (pid == 0) {
-            if (cmd->redirects) apply_redirection(cmd->redirects);
-            execvp(cmd->args[0], cmd->args);
-            perror("execvp");
-            exit(1);
-        } else if (pid > 0) {
-            int status;
-            waitpid(pid, &status, 0);
-            return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    // 변수 대입만 있는 명령어 (예: NAME=value OTHER=value)
+    if (!builtin && assignment_name_len(cmd->args[0])) {
+        int all = 1;
+        for (char **a = cmd->args; *a; a++) {
+            if (!assignment_name_len(*a)) all = 0;
+        }
+        if (all) {
+            for (char **a = cmd->args; *a; a++) {
+                size_t len = assignment_name_len(*a);
+                char name[256];
+                if (len >= sizeof(name)) continue;
+                memcpy(name, *a, len);
+                name[len] = '\0';
+                var_set(name, *a + len + 1, 0);
+            }
+            // x=$(cmd)의 종료 상태는 치환된 명령어의 상태
+            return expand_subst_status >= 0 ? expand_subst_status : 0;
+        }
+    }
+
+    // 내장 명령어는 쉘 프로세스 안에서 실행 (리다이렉션은 적용 후 되돌림)
+    if (builtin) {
+        int status;
+        if (cmd->redirects && (builtin->flags & BUILTIN_KEEP_REDIRECTS)) {
+            // exec 3>>log: 되돌리지 않으므로 이후 명령어가 같은 fd를 물려받는다
+            out_flush();
+            status = apply_redirection(cmd->redirects) < 0 ? 1 : builtin->fn(cmd->args);
+            out_fd_changed();
+        } else if (cmd->redirects) {
+            SavedFds saved;
+            status = redirect_push(cmd->redirects, &saved) < 0 ? 1 : builtin->fn(cmd->args);
+            redirect_pop(&saved);
         } else {
-            perror("fork");
-            return 1;
+            status = builtin->fn(cmd->args);
         }
+        out_end_command();
+        return status;
     }
 
-    // 다른 타입의 명령(CMD_IF, CMD_WHILE 등)은 execute_command() 재귀 호출로 처리
-    execute_command(cmd);
-    return 0;
-}
+    //외부 명령어 수행: 경로는 부모에서 해시 테이블로 미리 찾아 둔다
+    const char *path = cmdhash_lookup(cmd->args[0]);
+    if (!path) {
+        err_printf("%s: command not found\n", cmd->args[0]);
+        return 127;
+    }
 
+    out_flush();
+    STATS_BEGIN(t0);
+    pid_t pid = spawn_command(cmd, path, -1, -1, 0);
+    if (pid == -1) return errno == ENOENT ? 127 : 126;  // spawn 실패 (메시지는 출력됨)
+    if (pid == SPAWN_FALLBACK) pid = fork();  // spawn으로 표현할 수 없으면 fork 경로
+    if (pid > 0 && stats_enabled) {
+        uint64_t t1 = stats_now();
+        stats_record(STAT_SPAWN, t1 - t0);
+        stats_child_started(pid, t1);
+    }
 
+    if (pid == 0) {
+        if (cmd->redirects && apply_redirection(cmd->redirects) < 0) _exit(1);
+        environ = var_environ();   // execvp도 같은 환경을 쓰도록
+        execve(path, cmd->args, environ);
+        if (errno == ENOENT)
+            execvp(cmd->args[0], cmd->args);  // 캐시된 파일이 사라진 경우 다시 검색
+        perror("execve");
+        exit(errno == ENOENT ? 127 : 126);
+    } else if (pid > 0) {
+        int status;
+        wait_child(pid, &status, NULL);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    } else {
+        perror("fork");
+        return 1;
+    }
+}
 
-void execute_command(Command *cmd) {
-    if (!cmd) return;
+int execute_background(Command *cmd) {
+    out_flush();
+    pid_t pid = SPAWN_FALLBACK;
+    int own_group = jobs_control();         // 대화형이면 작업마다 자기 프로세스 그룹
+    const char *path = external_path(cmd);
+    if (path) pid = spawn_command(cmd, path, -1, -1, own_group);
+    if (pid == SPAWN_FALLBACK) {
+        pid = fork();
+        if (pid < 0) perror("fork");
+        // 부모와 자식 양쪽에서 설정해서 어느 쪽이 먼저 실행되어도 그룹이 정해져 있게 한다
+        if (pid > 0 && own_group) setpgid(pid, pid);
+    }
+    if (pid == 0) {
+        if (own_group) setpgid(0, 0);
+        int status = execute_and_get_status(cmd);
+        out_flush();
+        _exit(status);
+    }
+    if (pid > 0) {
+        last_bg_pid = pid;
+        jobs_add(pid, cmd->text, cmd->text_len);
+    }
+    return 0;
+}
 
-    switch (cmd->type) {
-        case CMD_SIMPLE:
-            execute_and_get_status(cmd);
-            break;
+int execute_subshell(Command *cmd) {
+    out_flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        // 자식에서 실행하므로 cd, 변수 변경 등이 부모 쉘에 남지 않음
+        int status = execute_and_get_status(cmd);
+        out_flush();
+        _exit(status);
+    }
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    int status;
+    wait_child(pid, &status, NULL);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
 
-        case CMD_SEQUENCE:
-            execute_command(cmd->left);
-            execute_command(cmd->right);
-            break;
+// for -j N 반복 하나의 상태
+typedef struct {
+    pid_t pid;
+    int out_fd, err_fd;      // 출력을 모아 두는 memfd (-1이면 바로 출력)
+    int status;
+    int done;
+} ForIteration;
+
+static void copy_captured(int from, int to) {
+    char buf[SUBST_READ_BLOCK];
+    ssize_t n;
+    if (from < 0 || lseek(from, 0, SEEK_SET) < 0) return;
+    while ((n = read(from, buf, sizeof(buf))) != 0) {
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 || write_all(to, buf, n) < 0) break;
+    }
+}
 
-        case CMD_PIPE: {
-        execute_pipeline(cmd);
-        break;
+static void start_iteration(Command *cmd, const char *word, ForIteration *it, const sigset_t *mask) {
+    it->out_fd = memfd_create("for-stdout", MFD_CLOEXEC);
+    it->err_fd = it->out_fd >= 0 ? memfd_create("for-stderr", MFD_CLOEXEC) : -1;
+
+    it->pid = fork();
+    if (it->pid == 0) {
+        sigprocmask(SIG_SETMASK, mask, NULL);
+        if (it->out_fd >= 0) dup2(it->out_fd, STDOUT_FILENO);
+        if (it->err_fd >= 0) dup2(it->err_fd, STDERR_FILENO);
+        var_set(cmd->args[0], word, 0);   // 반복마다 자기 프로세스에 변수 사본
+        int status = execute_and_get_status(cmd->then_block);
+        out_flush();
+        _exit(status);
+    }
+    if (it->pid < 0) {
+        perror("fork");
+        it->done = 1;
+        it->status = 1;
+    }
+}
+
+// 반복을 최대 cmd->parallel개까지 동시에 자식 프로세스에서 실행하고,
+// 각 반복의 출력은 memfd에 모았다가 반복 순서대로 내보낸다 (섞이지 않음).
+// 끝난 자식은 SIGCHLD를 막아 둔 채 sigsuspend()로 기다린다 (바쁜 대기 없음, 작업 표와도 겹치지 않음).
+int execute_parallel_for(Command *cmd) {
+    char **words = cmd->args + 1;
+    ExpandBuf *eb = NULL;
+    if (cmd->expand) {
+        STATS_BEGIN(t0);
+        eb = expand_acquire();
+        words = eb ? expand_words(eb, cmd->args + 1) : NULL;
+        STATS_END(STAT_EXPAND, t0);
+        if (!words) {
+            if (eb) expand_release();
+            return 1;
         }
+    }
 
+    int count = 0;
+    while (words[count]) count++;
+    ForIteration *its = calloc(count ? count : 1, sizeof(ForIteration));
+    if (!its) {
+        perror("for");
+        if (eb) expand_release();
+        return 1;
+    }
 
-        case CMD_AND: {
-            int status = execute_and_get_status(cmd->left);
-            if (status == 0)
-                execute_command(cmd->right);
-            break;
+    // 출력을 기다리는 반복이 너무 많아지지 않도록 시작할 수 있는 범위를 제한
+    int window = cmd->parallel * FOR_PARALLEL_WINDOW;
+    int next_start = 0, next_emit = 0, running = 0, status = 0;
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+
+    out_flush();
+    sigprocmask(SIG_BLOCK, &block, &old);
+    while (next_emit < count) {
+        while (running < cmd->parallel && next_start < count && next_start - next_emit < window) {
+            start_iteration(cmd, words[next_start], &its[next_start], &old);
+            if (!its[next_start].done) running++;
+            next_start++;
         }
 
-        case CMD_OR: {
-            int status = execute_and_get_status(cmd->left);
-            if (status != 0)
-                execute_command(cmd->right);
-            break;
+        int progress = 0;
+        for (int i = next_emit; i < next_start; i++) {
+            if (its[i].done) continue;
+            int st;
+            struct rusage ru;
+            pid_t r = wait4(its[i].pid, &st, WNOHANG, &ru);
+            if (r == 0 || (r < 0 && errno == EINTR)) continue;
+            if (r > 0) timing_child(&ru);
+            its[i].done = 1;
+            its[i].status = (r < 0) ? 1 : WIFEXITED(st) ? WEXITSTATUS(st) : 128 + WTERMSIG(st);
+            running--;
+            progress = 1;
         }
 
-        case CMD_BACKGROUND: {
-            pid_t pid = fork();
-            if (pid == 0) {
-                execute_command(cmd->left); exit(0);
+        while (next_emit < next_start && its[next_emit].done) {
+            ForIteration *it = &its[next_emit];
+            copy_captured(it->out_fd, STDOUT_FILENO);
+            copy_captured(it->err_fd, STDERR_FILENO);
+            if (it->out_fd >= 0) close(it->out_fd);
+            if (it->err_fd >= 0) close(it->err_fd);
+            if (it->status != 0) {
+                fprintf(stderr, "for: %s=%s: exit status %d\n", cmd->args[0], words[next_emit], it->status);
+                status = it->status;
             }
-            if (cmd->right) execute_command(cmd->right);
-            break;
+            next_emit++;
+            progress = 1;
         }
 
-        case CMD_IF: {
-            int status = execute_and_get_status(cmd->condition);
-            if (status == 0) {
-                execute_command(cmd->then_block);
-            } else if (cmd->else_block) {
-                execute_command(cmd->else_block);
-            }
-            break;
-        }
+        if (!progress) sigsuspend(&old);   // 자식이 끝나면 SIGCHLD로 깨어남
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
 
-        case CMD_FOR:
-            for (int i = 1; cmd->args[i]; i++) {
-                setenv(cmd->args[0], cmd->args[i], 1);
-                execute_command(cmd->then_block);
-            }
-            break;
+    free(its);
+    if (eb) expand_release();
+    return status;
+}
 
-        case CMD_WHILE:
-            while (1) {
-                int status = execute_and_get_status(cmd->condition);
-                if (status != 0) break;
-                execute_command(cmd->then_block);
-            }
-            break;
+// 트리를 바이트코드로 컴파일해서 실행 (반복문 본문도 한 번만 컴파일됨)
+int execute_and_get_status(Command *cmd) {
+    if (!cmd) return 1;
 
-        case CMD_GROUP:
-        case CMD_SUBSHELL:
-            execute_command(cmd->left);
-            break;
+    Program prog = { 0 };
+    compile_command(&prog, cmd);
+    int status = run_program(&prog);
+    free_program(&prog);
+    return status;
+}
 
-        default:
-            fprintf(stderr, "Unknown command type\n");
-            break;
+void execute_command(Command *cmd) {
+    execute_and_get_status(cmd);
+}
+
+// 토큰 스트림의 명령어들을 하나씩 파싱하고 실행한다 (명령어마다 arena를 비움)
+void execute_tokens(TokenStream *stream) {
+    while (1) {
+        Token *tok = peek_token(stream);
+        if (!tok || tok->type == T_EOF) break;
+
+        // 빈 줄과 구분자 건너뛰기
+        if (tok->type == T_OPERATOR && (token_equals(stream->src, tok, "\n") ||
+                                        token_equals(stream->src, tok, ";"))) {
+            next_token(stream);
+            continue;
+        }
+
+        int before = stream->pos;
+        STATS_BEGIN(t0);
+        Command *cmd = parse_command(stream);
+        STATS_END(STAT_PARSE, t0);
+        if (cmd) {
+            execute_command(cmd);        // 실제 명령 실행
+        }
+        arena_reset(stream->arena);      // 트리 전체를 O(1)로 해제
+
+        // 파싱 오류 등으로 진행하지 못했으면 다음 줄로 넘어감
+        if (!cmd || stream->pos == before) {
+            while ((tok = next_token(stream)) && tok->type != T_EOF &&
+                   !(tok->type == T_OPERATOR && token_equals(stream->src, tok, "\n")))
+                ;
+            if (tok && tok->type == T_EOF) break;
+        }
     }
 }
+
@@ -2,11 +2,40 @@
 #define EXECUTOR_H
 
 #include "parser.h"
+#include "builtins.h"
+
+#define MAX_PIPELINE_STAGES 64
+#define FOR_PARALLEL_WINDOW 4           // for -j N: 출력을 기다리는 반복은 최대 N*4개까지
+#define HEREDOC_PIPE_SIZE (64 * 1024)   // memfd를 못 쓸 때 기다리지 않고 파이프에 바로 쓸 수 있는 크기
+
+extern int shell_argc;       // 위치 매개변수 ($0, $1, ...)
+extern char **shell_argv;
+extern int last_status;      // $?
+extern pid_t shell_pid;      // $$ (서브쉘에서도 쉘 자신의 PID)
+extern pid_t last_bg_pid;    // $!
 
 // 주요 함수 선언
 void execute_command(Command *cmd);
-int execute_and_get_status(Command *cmd);
-void apply_redirection(Redirect *redir);
-void execute_pipeline(Command *cmd);
+void execute_tokens(TokenStream *stream);   // 스트림 끝까지 명령어를 하나씩 파싱하고 실행
+int execute_and_get_status(Command *cmd);            // 바이트코드로 컴파일해서 실행, 종료 상태 반환
+int execute_simple(Command *cmd, const Builtin *builtin);  // builtin이 NULL이면 외부 명령어
+int execute_background(Command *cmd);
+int execute_subshell(Command *cmd);
+int execute_parallel_for(Command *cmd);   // for -j N: 실패한 반복이 있으면 그 상태 반환
+int apply_redirection(Redirect *redir);   // 실패하면 -1
+
+// 내장 명령어처럼 쉘 프로세스 안에서 리다이렉션할 때 원래 fd를 보관
+#define MAX_SAVED_FDS 16
+#define SAVED_FD_BASE 10      // 복제본은 10번 이상 fd에 둔다
+typedef struct {
+    int fd[MAX_SAVED_FDS];    // 바뀐 fd 번호
+    int copy[MAX_SAVED_FDS];  // 원래 fd의 복제본 (-1이면 원래 닫혀 있었음)
+    int count;
+} SavedFds;
+
+int redirect_push(Redirect *redir, SavedFds *saved);   // 적용 실패하면 -1
+void redirect_pop(SavedFds *saved);
+int redirect_push_command(Command *cmd, SavedFds *saved);   // 복합 명령어: 파일 이름을 확장해서 적용
+int execute_pipeline(Command *cmd);   // 모든 단계를 동시에 실행, 마지막 단계의 상태 반환
 
 #endif // EXECUTOR_H
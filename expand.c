@@ -0,0 +1,875 @@
+#define _GNU_SOURCE   // memmem(), pipe2()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "expand.h"
+#include "executer.h"
+#include "vars.h"
+#include "pattern.h"
+#include "timing.h"
+
+#define EXPAND_MAX_DEPTH 64
+#define DEFAULT_IFS " \t\n"
+
+static int append_raw(ExpandBuf *eb, const char *s, size_t len, int quoted);
+static int append_command_subst(ExpandBuf *eb, const char *text, size_t len, int quoted);
+
+int expand_subst_status = -1;
+
+static int pattern_mode = 0;       // ${v#p}의 p처럼 패턴을 만드는 중이면 1 (단어를 나누지 않음)
+static char *scratch = NULL;       // 패턴/치환 문자열을 잠시 옮겨 두는 곳 (재사용)
+static size_t scratch_cap = 0;
+
+// ---- 버퍼 ----
+
+static void eb_reserve(ExpandBuf *eb, size_t n) {
+    if (eb->len + n <= eb->cap) return;
+    size_t new_cap = eb->cap ? eb->cap : 256;
+    while (new_cap < eb->len + n) new_cap *= 2;
+    char *grown = realloc(eb->buf, new_cap);
+    if (!grown) {
+        perror("expand");
+        exit(EXIT_FAILURE);
+    }
+    eb->buf = grown;
+    eb->cap = new_cap;
+}
+
+static void eb_put(ExpandBuf *eb, const char *s, size_t n) {
+    eb_reserve(eb, n);
+    memcpy(eb->buf + eb->len, s, n);
+    eb->len += n;
+}
+
+static void eb_putc(ExpandBuf *eb, char c) {
+    eb_reserve(eb, 1);
+    eb->buf[eb->len++] = c;
+}
+
+static void begin_field(ExpandBuf *eb) {
+    eb->field_start = eb->len;
+    eb->field_content = 0;
+}
+
+// 만들던 단어를 끝낸다. 비어 있고 따옴표도 없었으면 버림 (예: 빈 $x)
+static void end_field(ExpandBuf *eb) {
+    if (eb->len > eb->field_start || eb->field_content) {
+        if (eb->count >= eb->offs_cap) {
+            int new_cap = eb->offs_cap ? eb->offs_cap * 2 : 16;
+            size_t *grown = realloc(eb->offs, new_cap * sizeof(size_t));
+            if (!grown) {
+                perror("expand");
+                exit(EXIT_FAILURE);
+            }
+            eb->offs = grown;
+            eb->offs_cap = new_cap;
+        }
+        eb->offs[eb->count++] = eb->field_start;
+        eb_putc(eb, '\0');
+    } else {
+        eb->len = eb->field_start;
+    }
+    begin_field(eb);
+}
+
+// 따옴표 밖 확장 결과: IFS 글자에서 단어를 나눈다 (연속된 공백류는 하나로)
+static void append_split(ExpandBuf *eb, const char *s, size_t n) {
+    const char *ifs = var_get("IFS");
+    if (!ifs) ifs = DEFAULT_IFS;
+
+    for (size_t i = 0; i < n; i++) {
+        char c = s[i];
+        if (!c || !strchr(ifs, c)) {
+            eb_putc(eb, c);
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\n') {
+            if (eb->len > eb->field_start || eb->field_content) end_field(eb);
+        } else {
+            eb->field_content = 1;   // 공백이 아닌 구분자는 빈 단어도 만든다
+            end_field(eb);
+        }
+    }
+}
+
+static void append_value(ExpandBuf *eb, const char *s, size_t n, int quoted) {
+    if (pattern_mode) {
+        // 패턴 안의 따옴표 부분은 글자 그대로 맞도록 glob 문자를 이스케이프
+        for (size_t i = 0; i < n; i++) {
+            if (quoted && s[i] && strchr("*?[\\", s[i])) eb_putc(eb, '\\');
+            eb_putc(eb, s[i]);
+        }
+        return;
+    }
+    if (quoted) {
+        eb_put(eb, s, n);
+        eb->field_content = 1;
+    } else {
+        append_split(eb, s, n);
+    }
+}
+
+// ---- 매개변수 ----
+
+// $@, $* 이외의 매개변수 값 (없으면 NULL). 숫자 값은 numbuf에 만든다
+static const char *param_value(const char *name, size_t len, char *numbuf, size_t numbuf_size) {
+    if (isdigit((unsigned char)name[0])) {
+        int n = atoi(name);
+        return n < shell_argc ? shell_argv[n] : NULL;
+    }
+    if (len == 1) {
+        switch (name[0]) {
+            case '?': snprintf(numbuf, numbuf_size, "%d", last_status); return numbuf;
+            case '#': snprintf(numbuf, numbuf_size, "%d", shell_argc > 0 ? shell_argc - 1 : 0); return numbuf;
+            case '$': snprintf(numbuf, numbuf_size, "%d", (int)shell_pid); return numbuf;
+            case '!':
+                if (!last_bg_pid) return NULL;
+                snprintf(numbuf, numbuf_size, "%d", (int)last_bg_pid);
+                return numbuf;
+            case '-': return "";
+        }
+    }
+    return var_get(name);
+}
+
+// $@, $*: 위치 매개변수 전체. "$@"만 매개변수마다 따로 단어를 만든다
+static void append_positional(ExpandBuf *eb, char which, int quoted) {
+    const char *ifs = var_get("IFS");
+    char sep = ifs ? ifs[0] : ' ';
+
+    for (int i = 1; i < shell_argc; i++) {
+        if (i > 1) {
+            if (quoted && which == '@') {
+                eb->field_content = 1;
+                end_field(eb);
+            } else if (quoted) {
+                if (sep) eb_putc(eb, sep);
+            } else {
+                append_split(eb, " ", 1);
+            }
+        }
+        append_value(eb, shell_argv[i], strlen(shell_argv[i]), quoted);
+    }
+}
+
+// 식 앞부분의 매개변수 이름 길이 (이름, 숫자, 특수 문자 하나)
+static size_t param_name_len(const char *expr, size_t len) {
+    size_t nlen = 0;
+    if (len > 0 && (isalpha((unsigned char)expr[0]) || expr[0] == '_')) {
+        while (nlen < len && (isalnum((unsigned char)expr[nlen]) || expr[nlen] == '_')) nlen++;
+    } else if (len > 0 && isdigit((unsigned char)expr[0])) {
+        while (nlen < len && isdigit((unsigned char)expr[nlen])) nlen++;
+    } else if (len > 0) {
+        nlen = 1;   // 특수 매개변수
+    }
+    return nlen;
+}
+
+// ${v/p/r}, ${v:o:l}에서 구분자 위치 (이스케이프, 따옴표, 중첩 ${}는 건너뜀). 없으면 end
+static const char *find_delim(const char *p, const char *end, char delim) {
+    int braces = 0;
+    char quote = 0;
+    for (; p < end; p++) {
+        if (*p == '\\' && p + 1 < end) { p++; continue; }
+        if (quote) { if (*p == quote) quote = 0; continue; }
+        if (*p == '\'' || *p == '"') { quote = *p; continue; }
+        if (*p == '{') braces++;
+        else if (*p == '}') braces--;
+        else if (*p == delim && braces <= 0) return p;
+    }
+    return end;
+}
+
+// 패턴(또는 문자열) 단어 둘을 확장해서 scratch에 "first\0second\0"로 옮긴다.
+// 중첩된 연산이 scratch를 다시 쓰더라도 둘 다 끝난 뒤에 옮기므로 안전하다.
+static int expand_operands(ExpandBuf *eb, const char *first, size_t first_len, int first_pattern,
+                           const char *second, size_t second_len, size_t *split_at) {
+    size_t mark = eb->len, field_start = eb->field_start;
+    int field_content = eb->field_content, saved_mode = pattern_mode, r;
+
+    pattern_mode = first_pattern;
+    r = append_raw(eb, first, first_len, !first_pattern);
+    *split_at = eb->len - mark;
+    eb_putc(eb, '\0');
+    pattern_mode = 0;
+    if (r == 0 && second) r = append_raw(eb, second, second_len, 1);
+    eb_putc(eb, '\0');
+    pattern_mode = saved_mode;
+
+    size_t n = eb->len - mark;
+    if (n > scratch_cap) {
+        char *grown = realloc(scratch, n * 2);
+        if (!grown) {
+            perror("expand");
+            exit(EXIT_FAILURE);
+        }
+        scratch = grown;
+        scratch_cap = n * 2;
+    }
+    memcpy(scratch, eb->buf + mark, n);
+    eb->len = mark;
+    eb->field_start = field_start;
+    eb->field_content = field_content;
+    return r;
+}
+
+// ${v#p} ${v##p} ${v%p} ${v%%p}
+static void append_trim(ExpandBuf *eb, const char *value, const Pattern *pat, int suffix, int longest, int quoted) {
+    size_t n = strlen(value), min = pattern_min_len(pat);
+    size_t cut = 0;        // 잘라낼 길이
+    const char *lit;
+    size_t lit_len;
+
+    if (min > n) {
+        append_value(eb, value, n, quoted);
+        return;
+    }
+    if (pattern_is_literal(pat, &lit, &lit_len)) {
+        if (!suffix && memcmp(value, lit, lit_len) == 0) cut = lit_len;
+        if (suffix && memcmp(value + n - lit_len, lit, lit_len) == 0) cut = lit_len;
+    } else if (!suffix) {
+        // 앞에서부터: 가장 짧은(#) 또는 가장 긴(##) 일치
+        for (size_t i = longest ? n : min; longest ? i + 1 > min : i <= n; longest ? i-- : i++) {
+            if (pattern_match(pat, value, i)) { cut = i; break; }
+        }
+    } else {
+        for (size_t i = longest ? n : min; longest ? i + 1 > min : i <= n; longest ? i-- : i++) {
+            if (pattern_match(pat, value + n - i, i)) { cut = i; break; }
+        }
+    }
+
+    if (suffix) append_value(eb, value, n - cut, quoted);
+    else append_value(eb, value + cut, n - cut, quoted);
+}
+
+// value[i..]에서 시작하는 가장 긴 (빈 문자열이 아닌) 일치 길이, 없으면 0
+static size_t longest_match_at(const Pattern *pat, const char *value, size_t i, size_t n) {
+    size_t min = pattern_min_len(pat);
+    if (min == 0) min = 1;
+    for (size_t j = n; j >= i + min; j--) {
+        if (pattern_match(pat, value + i, j - i)) return j - i;
+    }
+    return 0;
+}
+
+// ${v/p/r} ${v//p/r} ${v/#p/r} ${v/%p/r}
+static void append_replace(ExpandBuf *eb, const char *value, const Pattern *pat, const char *rep,
+                           char mode, int quoted) {
+    size_t n = strlen(value), rep_len = strlen(rep);
+    size_t done = 0;     // 결과에 이미 옮긴 위치
+    const char *lit;
+    size_t lit_len;
+    int literal = pattern_is_literal(pat, &lit, &lit_len) && lit_len > 0;
+
+    if (mode == '#' || mode == '%') {
+        // 맨 앞 또는 맨 끝에 붙은 가장 긴 일치 하나만
+        size_t pos = 0, m = 0;
+        if (mode == '#') {
+            m = longest_match_at(pat, value, 0, n);
+        } else {
+            for (pos = 0; pos < n; pos++) {
+                if (pattern_match(pat, value + pos, n - pos)) { m = n - pos; break; }
+            }
+        }
+        if (m == 0) {
+            append_value(eb, value, n, quoted);
+            return;
+        }
+        append_value(eb, value, pos, quoted);
+        append_value(eb, rep, rep_len, quoted);
+        append_value(eb, value + pos + m, n - pos - m, quoted);
+        return;
+    }
+
+    for (size_t i = 0; i < n; ) {
+        size_t pos, m = 0;
+        if (literal) {
+            // 와일드카드 없는 패턴은 memmem으로 다음 위치를 바로 찾는다
+            const char *hit = memmem(value + i, n - i, lit, lit_len);
+            if (!hit) break;
+            pos = hit - value;
+            m = lit_len;
+        } else {
+            for (pos = i; pos < n; pos++) {
+                m = longest_match_at(pat, value, pos, n);
+                if (m) break;
+            }
+            if (!m) break;
+        }
+        append_value(eb, value + done, pos - done, quoted);
+        append_value(eb, rep, rep_len, quoted);
+        done = i = pos + m;
+        if (mode != '/') break;        // //만 전부 바꿈
+    }
+    append_value(eb, value + done, n - done, quoted);
+}
+
+// ${v/...}, ${v#...}, ${v%...}, ${v:o:l}
+static int append_string_op(ExpandBuf *eb, const char *value, const char *op, size_t op_len, int quoted) {
+    const char *end = op + op_len;
+    size_t split_at;
+
+    if (!value) value = "";
+
+    if (op[0] == '#' || op[0] == '%') {
+        int longest = (op_len > 1 && op[1] == op[0]);
+        const char *pat = op + 1 + longest;
+        if (expand_operands(eb, pat, end - pat, 1, NULL, 0, &split_at) < 0) return -1;
+        append_trim(eb, value, pattern_get(scratch), op[0] == '%', longest, quoted);
+        return 0;
+    }
+
+    if (op[0] == '/') {
+        char mode = 0;          // 0: 처음 하나, '/': 전부, '#': 맨 앞, '%': 맨 뒤
+        const char *pat = op + 1;
+        if (pat < end && (*pat == '/' || *pat == '#' || *pat == '%')) mode = *pat++;
+        const char *slash = find_delim(pat, end, '/');
+        const char *rep = slash < end ? slash + 1 : end;
+        if (expand_operands(eb, pat, slash - pat, 1, rep, end - rep, &split_at) < 0) return -1;
+        if (split_at == 0) {    // 빈 패턴: 그대로
+            append_value(eb, value, strlen(value), quoted);
+            return 0;
+        }
+        append_replace(eb, value, pattern_get(scratch), scratch + split_at + 1, mode, quoted);
+        return 0;
+    }
+
+    // ${v:offset} / ${v:offset:length} (음수는 끝에서부터)
+    const char *off = op + 1;
+    const char *colon = find_delim(off, end, ':');
+    if (expand_operands(eb, off, colon - off, 0, colon < end ? colon + 1 : NULL,
+                        colon < end ? end - colon - 1 : 0, &split_at) < 0) return -1;
+
+    long n = strlen(value);
+    long start = strtol(scratch, NULL, 10);
+    long count = n;
+    if (start < 0) start += n;
+    if (start < 0) start = 0;
+    if (start > n) start = n;
+    if (colon < end) {
+        count = strtol(scratch + split_at + 1, NULL, 10);
+        if (count < 0) count = (n + count) - start;   // 끝에서부터 잘라냄
+        if (count < 0) {
+            fprintf(stderr, "%.*s: substring expression < 0\n", (int)(colon - off), off);
+            return -1;
+        }
+    }
+    if (start + count > n) count = n - start;
+    append_value(eb, value + start, count, quoted);
+    return 0;
+}
+
+// expr: $ 뒤의 본문 ("x", "x:-word", "?" ...)
+static int append_param(ExpandBuf *eb, const char *expr, size_t len, int quoted) {
+    char name[256], numbuf[32];
+
+    // ${#v}: 값의 길이 (${#}는 매개변수 개수)
+    if (len > 1 && expr[0] == '#') {
+        size_t nlen = param_name_len(expr + 1, len - 1);
+        if (nlen != len - 1 || nlen >= sizeof(name)) {
+            fprintf(stderr, "${%.*s}: bad substitution\n", (int)len, expr);
+            return -1;
+        }
+        memcpy(name, expr + 1, nlen);
+        name[nlen] = '\0';
+        size_t length;
+        if (nlen == 1 && (name[0] == '@' || name[0] == '*')) {
+            length = shell_argc > 0 ? shell_argc - 1 : 0;
+        } else {
+            const char *v = param_value(name, nlen, numbuf, sizeof(numbuf));
+            length = v ? strlen(v) : 0;
+        }
+        snprintf(numbuf, sizeof(numbuf), "%zu", length);
+        append_value(eb, numbuf, strlen(numbuf), quoted);
+        return 0;
+    }
+
+    size_t nlen = param_name_len(expr, len);
+    if (nlen == 0 || nlen >= sizeof(name)) {
+        fprintf(stderr, "${%.*s}: bad substitution\n", (int)len, expr);
+        return -1;
+    }
+    memcpy(name, expr, nlen);
+    name[nlen] = '\0';
+
+    const char *op = expr + nlen;
+    size_t op_len = len - nlen;
+    int positional = (nlen == 1 && (name[0] == '@' || name[0] == '*'));
+
+    if (quoted && !positional) eb->field_content = 1;   // "$x"는 비어 있어도 한 단어 ("$@"만 예외)
+
+    const char *value = NULL;
+    if (positional) value = shell_argc > 1 ? "" : NULL;
+    else value = param_value(name, nlen, numbuf, sizeof(numbuf));
+
+    if (op_len == 0) {
+        if (positional) append_positional(eb, name[0], quoted);
+        else if (value) append_value(eb, value, strlen(value), quoted);
+        else if (quoted) eb->field_content = 1;
+        return 0;
+    }
+
+    // 문자열 연산: #, %, /, :offset
+    if (op[0] == '#' || op[0] == '%' || op[0] == '/' || (op[0] == ':' && (op_len == 1 || !strchr("-=+?", op[1])))) {
+        if (positional) {
+            fprintf(stderr, "${%.*s}: bad substitution\n", (int)len, expr);
+            return -1;
+        }
+        return append_string_op(eb, value, op, op_len, quoted);
+    }
+
+    // ${x-word}, ${x:-word} ... : 콜론이 있으면 빈 값도 "없음"으로 본다
+    int colon = (op[0] == ':');
+    char kind = op[colon];
+    const char *word = op + colon + 1;
+    size_t word_len = op_len - colon - 1;
+    int missing = !value || (colon && !*value);
+
+    if (colon + 1 > (int)op_len || !strchr("-=+?", kind)) {
+        fprintf(stderr, "${%.*s}: bad substitution\n", (int)len, expr);
+        return -1;
+    }
+
+    switch (kind) {
+        case '-':
+            if (missing) return append_raw(eb, word, word_len, quoted);
+            break;
+        case '+':
+            if (!missing) return append_raw(eb, word, word_len, quoted);
+            if (quoted) eb->field_content = 1;
+            return 0;
+        case '=': {
+            if (!missing) break;
+            if (positional || !(isalpha((unsigned char)name[0]) || name[0] == '_')) {
+                fprintf(stderr, "$%s: cannot assign in this way\n", name);
+                return -1;
+            }
+            // 기본값을 버퍼 끝에 만든 뒤 변수에 넣는다 (그 자리가 곧 확장 결과)
+            size_t mark = eb->len;
+            if (append_raw(eb, word, word_len, 1) < 0) return -1;
+            char *assigned = strndup(eb->buf + mark, eb->len - mark);
+            if (assigned) {
+                var_set(name, assigned, 0);
+                free(assigned);
+            }
+            return 0;
+        }
+        case '?':
+            if (missing) {
+                if (word_len) fprintf(stderr, "%s: %.*s\n", name, (int)word_len, word);
+                else fprintf(stderr, "%s: parameter null or not set\n", name);
+                return -1;
+            }
+            break;
+    }
+
+    if (positional) append_positional(eb, name[0], quoted);
+    else if (value) append_value(eb, value, strlen(value), quoted);
+    else if (quoted) eb->field_content = 1;
+    return 0;
+}
+
+// p에서 시작하는 $x, ${...}, $(...), $? 하나를 확장하고 쓴 길이를 돌려준다 (확장이 아니면 0, 실패 -1)
+static long append_dollar(ExpandBuf *eb, const char *p, const char *end, int quoted) {
+    if (p + 1 >= end) return 0;
+    if (p[1] == '{') {
+        const char *body = p + 2, *q = body;
+        int braces = 1;
+        while (q < end) {
+            if (*q == '{') braces++;
+            else if (*q == '}' && --braces == 0) break;
+            q++;
+        }
+        if (append_param(eb, body, q - body, quoted) < 0) return -1;
+        return (q < end ? q + 1 : end) - p;
+    }
+    if (p[1] == '(') {
+        const char *body = p + 2, *q = body;
+        int parens = 1;
+        while (q < end) {
+            if (*q == '(') parens++;
+            else if (*q == ')' && --parens == 0) break;
+            q++;
+        }
+        if (append_command_subst(eb, body, q - body, quoted) < 0) return -1;
+        return (q < end ? q + 1 : end) - p;
+    }
+    if (isalpha((unsigned char)p[1]) || p[1] == '_') {
+        const char *body = p + 1, *q = body;
+        while (q < end && (isalnum((unsigned char)*q) || *q == '_')) q++;
+        if (append_param(eb, body, q - body, quoted) < 0) return -1;
+        return q - p;
+    }
+    if (strchr("?#$!@*-0123456789", p[1])) {
+        if (append_param(eb, p + 1, 1, quoted) < 0) return -1;
+        return 2;
+    }
+    return 0;
+}
+
+// ${...} 안의 기본값처럼 파서를 거치지 않은 원문 단어를 확장한다
+static int append_raw(ExpandBuf *eb, const char *s, size_t len, int quoted) {
+    const char *end = s + len;
+    int in_dq = 0;
+    long n;
+
+    for (const char *p = s; p < end; p++) {
+        int q = quoted || in_dq;
+
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+            append_value(eb, p, 1, 1);
+        } else if (*p == '\'' && !in_dq) {
+            const char *close = memchr(p + 1, '\'', end - p - 1);
+            if (!close) close = end;
+            append_value(eb, p + 1, close - p - 1, 1);
+            p = close < end ? close : end - 1;
+        } else if (*p == '"') {
+            in_dq = !in_dq;
+            eb->field_content = 1;
+        } else if (*p == '$' && (n = append_dollar(eb, p, end, q)) != 0) {
+            if (n < 0) return -1;
+            p += n - 1;
+        } else {
+            append_value(eb, p, 1, q);
+        }
+    }
+    return 0;
+}
+
+// ---- 명령 치환 ----
+
+// 캡처한 출력 [mark, eb->len)을 확장 결과로 만든다: 끝 줄바꿈을 제자리에서 자르고,
+// 따옴표 밖이면 같은 버퍼 안에서 단어를 나눈다 (나눈 결과는 원본보다 길어지지 않음)
+static void finish_capture(ExpandBuf *eb, size_t mark, int quoted) {
+    while (eb->len > mark && eb->buf[eb->len - 1] == '\n') eb->len--;
+    size_t n = eb->len - mark;
+
+    if (pattern_mode) {
+        // 패턴 안에서는 이스케이프 때문에 길어질 수 있으므로 따로 복사
+        char *copy = malloc(n ? n : 1);
+        if (!copy) return;
+        memcpy(copy, eb->buf + mark, n);
+        eb->len = mark;
+        append_value(eb, copy, n, quoted);
+        free(copy);
+    } else if (quoted) {
+        eb->field_content = 1;
+    } else {
+        eb->len = mark;
+        append_split(eb, eb->buf + mark, n);
+    }
+}
+
+// 파이프에서 EOF까지 읽어 eb 끝에 붙인다 (버퍼는 두 배씩 늘어나므로 전체 복사는 O(n))
+static void read_all(ExpandBuf *eb, int fd) {
+    while (1) {
+        eb_reserve(eb, SUBST_READ_BLOCK);
+        ssize_t n = read(fd, eb->buf + eb->len, eb->cap - eb->len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        eb->len += n;
+    }
+}
+
+// 명령어 하나짜리이고 쉘 상태를 바꾸지 않는 내장 명령어면 그 명령어
+static Command *single_pure_builtin(TokenStream *stream, const Builtin **builtin) {
+    while (stream->pos < stream->count && stream->tokens[stream->pos].type == T_OPERATOR &&
+           (token_equals(stream->src, &stream->tokens[stream->pos], "\n") ||
+            token_equals(stream->src, &stream->tokens[stream->pos], ";")))
+        stream->pos++;
+
+    Command *cmd = parse_command(stream);
+    while (stream->pos < stream->count && stream->tokens[stream->pos].type == T_OPERATOR &&
+           token_equals(stream->src, &stream->tokens[stream->pos], "\n"))
+        stream->pos++;
+
+    if (!cmd || cmd->type != CMD_SIMPLE || cmd->redirects || !cmd->args[0] ||
+        word_has_expansion(cmd->args[0]) || stream->pos >= stream->count ||
+        stream->tokens[stream->pos].type != T_EOF)
+        return NULL;
+    *builtin = find_builtin(cmd->args[0]);
+    if (!*builtin || !((*builtin)->flags & BUILTIN_PURE)) return NULL;
+    return cmd;
+}
+
+// $(text): 출력을 확장 결과로. 단일 내장 명령어는 fork 없이 쉘 안에서 실행
+static int append_command_subst(ExpandBuf *eb, const char *text, size_t len, int quoted) {
+    char *src = strndup(text, len);      // tokenize()는 '\0'으로 끝나는 입력이 필요
+    if (!src) return -1;
+
+    TokenList tokens = { 0 };
+    Arena arena = { 0 };
+    tokenize(&tokens, src);
+    TokenStream stream = {
+        .tokens = tokens.data,
+        .count = tokens.count,
+        .pos = 0,
+        .src = src,
+        .arena = &arena
+    };
+
+    const Builtin *builtin = NULL;
+    Command *cmd = single_pure_builtin(&stream, &builtin);
+    size_t mark = eb->len;
+    int status = 0;
+
+    if (cmd) {
+        ExpandBuf *inner = expand_acquire();
+        char **argv = inner ? (cmd->expand ? expand_words(inner, cmd->args) : cmd->args) : NULL;
+        if (argv) {
+            size_t n;
+            out_capture_begin();
+            status = builtin->fn(argv);
+            const char *out = out_capture_end(&n);
+            eb_put(eb, out, n);
+        } else {
+            status = 1;
+        }
+        if (inner) expand_release();
+    } else {
+        int pipefd[2];
+        if (pipe2(pipefd, O_CLOEXEC) < 0) {
+            perror("pipe");
+            status = -1;
+        } else {
+            out_flush();
+            pid_t pid = fork();
+            if (pid == 0) {
+                dup2(pipefd[1], STDOUT_FILENO);
+                close(pipefd[0]);
+                close(pipefd[1]);
+                out_fd_changed();
+                stream.pos = 0;
+                arena_reset(&arena);
+                execute_tokens(&stream);
+                out_flush();
+                _exit(last_status);
+            }
+            close(pipefd[1]);
+            if (pid < 0) {
+                perror("fork");
+                status = -1;
+            } else {
+                read_all(eb, pipefd[0]);
+                int wstatus;
+                wait_child(pid, &wstatus, NULL);
+                status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+            }
+            close(pipefd[0]);
+        }
+    }
+
+    arena_free(&arena);
+    free_tokens(&tokens);
+    free(src);
+    if (status < 0) return -1;
+
+    expand_subst_status = last_status = status;
+    finish_capture(eb, mark, quoted);
+    return 0;
+}
+
+void expand_reset_status(void) {
+    expand_subst_status = -1;
+}
+
+// 파서가 만든 단어 틀을 한 번 훑으며 확장한다
+static int append_template(ExpandBuf *eb, const char *word, int split) {
+    const char *p = word;
+    while (*p) {
+        size_t n = strcspn(p, "\001\002\003\004\005\006");
+        if (n) {
+            eb_put(eb, p, n);
+            p += n;
+            continue;
+        }
+        char marker = *p++;
+        if (marker == WEXP_QEMPTY) {
+            eb->field_content = 1;
+            continue;
+        }
+        if (marker == WEXP_END) continue;
+
+        const char *end = strchr(p, WEXP_END);
+        if (!end) end = p + strlen(p);
+        int quoted = (marker == WEXP_QPARAM || marker == WEXP_QCMD || !split);
+        if (marker == WEXP_CMD || marker == WEXP_QCMD) {
+            if (append_command_subst(eb, p, end - p, quoted) < 0) return -1;
+        } else if (append_param(eb, p, end - p, quoted) < 0) {
+            return -1;
+        }
+        p = *end ? end + 1 : end;
+    }
+    return 0;
+}
+
+// 맨 앞의 NAME=... 단어 (대입의 오른쪽은 나누지 않음)
+static int is_assignment_template(const char *word) {
+    const char *eq = strchr(word, '=');
+    if (!eq) return 0;
+    if (!(isalpha((unsigned char)word[0]) || word[0] == '_')) return 0;
+    for (const char *p = word + 1; p < eq; p++) {
+        if (!(isalnum((unsigned char)*p) || *p == '_')) return 0;
+    }
+    return 1;
+}
+
+int word_has_expansion(const char *word) {
+    return word && strpbrk(word, "\001\002\004\005\006") != NULL;
+}
+
+static int expand_word_list(ExpandBuf *eb, char **words, int assignments) {
+    for (int i = 0; words[i]; i++) {
+        if (assignments && !is_assignment_template(words[i])) assignments = 0;
+        begin_field(eb);
+        if (!word_has_expansion(words[i])) {
+            eb_put(eb, words[i], strlen(words[i]));
+            eb->field_content = 1;   // "" 같은 빈 리터럴도 인자로 남김
+        } else if (append_template(eb, words[i], !assignments) < 0) {
+            return -1;
+        }
+        end_field(eb);
+    }
+    return 0;
+}
+
+// offs를 포인터 배열로 바꾼다 (버퍼가 다 만들어진 다음에만)
+static char **build_argv(ExpandBuf *eb, int count) {
+    if (count + 1 > eb->argv_cap) {
+        int new_cap = (count + 1) * 2;
+        char **grown = realloc(eb->argv, new_cap * sizeof(char *));
+        if (!grown) {
+            perror("expand");
+            exit(EXIT_FAILURE);
+        }
+        eb->argv = grown;
+        eb->argv_cap = new_cap;
+    }
+    for (int i = 0; i < count; i++) eb->argv[i] = eb->buf + eb->offs[i];
+    eb->argv[count] = NULL;
+    return eb->argv;
+}
+
+char **expand_words(ExpandBuf *eb, char **words) {
+    eb->len = 0;
+    eb->count = 0;
+    if (expand_word_list(eb, words, 0) < 0) return NULL;
+    return build_argv(eb, eb->count);
+}
+
+int expand_command(Command *cmd, Command *out, ExpandBuf *eb) {
+    eb->len = 0;
+    eb->count = 0;
+    *out = *cmd;
+
+    if (cmd->args && expand_word_list(eb, cmd->args, 1) < 0) return -1;
+    int argc = eb->count;
+
+    // 리다이렉션 파일 이름: 나누지 않고 한 단어로
+    int nredirs = 0, need_copy = 0;
+    for (Redirect *r = cmd->redirects; r; r = r->next) {
+        nredirs++;
+        if (!word_has_expansion(r->file)) continue;
+        need_copy = 1;
+        begin_field(eb);
+        if (append_template(eb, r->file, 0) < 0) return -1;
+        eb->field_content = 1;
+        end_field(eb);
+    }
+
+    out->args = build_argv(eb, argc);
+    if (!need_copy) return 0;
+
+    if (nredirs > eb->redirs_cap) {
+        Redirect *grown = realloc(eb->redirs, nredirs * sizeof(Redirect));
+        if (!grown) {
+            perror("expand");
+            exit(EXIT_FAILURE);
+        }
+        eb->redirs = grown;
+        eb->redirs_cap = nredirs;
+    }
+    int i = 0, k = argc;
+    for (Redirect *r = cmd->redirects; r; r = r->next, i++) {
+        eb->redirs[i] = *r;
+        if (word_has_expansion(r->file)) eb->redirs[i].file = eb->buf + eb->offs[k++];
+        eb->redirs[i].next = (i + 1 < nredirs) ? &eb->redirs[i + 1] : NULL;
+    }
+    out->redirects = eb->redirs;
+    return 0;
+}
+
+// heredoc 본문을 전달할 내용으로 만든다. 확장도 탭 제거도 없으면 본문을 그대로 돌려준다.
+// 따옴표는 그냥 글자이고, \는 $ ` \ 줄바꿈 앞에서만 특별하다
+const char *expand_heredoc(ExpandBuf *eb, const Redirect *r, size_t *len) {
+    if (!(r->heredoc_flags & (HEREDOC_EXPAND | HEREDOC_STRIP_TABS))) {
+        *len = r->body_len;
+        return r->body;
+    }
+    const char *p = r->body, *end = r->body + r->body_len;
+    int line_start = 1;
+    eb->len = 0;
+    eb->count = 0;
+
+    while (p < end) {
+        if (line_start && (r->heredoc_flags & HEREDOC_STRIP_TABS)) {
+            while (p < end && *p == '\t') p++;
+            if (p >= end) break;
+        }
+        if (!(r->heredoc_flags & HEREDOC_EXPAND)) {      // <<-'EOF': 줄 단위로 그대로
+            const char *eol = memchr(p, '\n', end - p);
+            eol = eol ? eol + 1 : end;
+            eb_put(eb, p, eol - p);
+            p = eol;
+            line_start = 1;
+            continue;
+        }
+        long n;
+        if (*p == '\\' && p + 1 < end && strchr("$`\\\n", p[1])) {
+            if (p[1] != '\n') eb_putc(eb, p[1]);
+            p += 2;
+            line_start = 0;
+            continue;
+        }
+        if (*p == '$' && (n = append_dollar(eb, p, end, 1)) != 0) {
+            if (n < 0) return NULL;
+            p += n;
+            line_start = 0;
+            continue;
+        }
+        line_start = (*p == '\n');
+        eb_putc(eb, *p++);
+    }
+    *len = eb->len;
+    return eb->buf ? eb->buf : "";
+}
+
+void expand_buf_free(ExpandBuf *eb) {
+    free(eb->buf);
+    free(eb->offs);
+    free(eb->argv);
+    free(eb->redirs);
+    memset(eb, 0, sizeof(*eb));
+}
+
+static ExpandBuf *pool[EXPAND_MAX_DEPTH];
+static int pool_depth = 0;
+
+ExpandBuf *expand_acquire(void) {
+    if (pool_depth >= EXPAND_MAX_DEPTH) {
+        fprintf(stderr, "expand: nesting too deep\n");
+        return NULL;
+    }
+    if (!pool[pool_depth]) pool[pool_depth] = calloc(1, sizeof(ExpandBuf));
+    return pool[pool_depth++];
+}
+
+void expand_release(void) {
+    if (pool_depth > 0) pool_depth--;
+}
@@ -0,0 +1,52 @@
+#ifndef EXPAND_H
+#define EXPAND_H
+
+#include <stddef.h>
+#include "parser.h"
+
+// 파서는 확장이 필요한 단어를 "틀(template)"로 저장한다.
+// 리터럴 글자 사이에 아래 표시 바이트로 감싼 매개변수 식이 들어간다.
+//   WEXP_PARAM  식 WEXP_END   : 따옴표 밖 $x, ${x...} (결과를 IFS로 나눔)
+//   WEXP_QPARAM 식 WEXP_END   : 큰따옴표 안 "$x"
+//   WEXP_QEMPTY               : 따옴표가 있었음 (결과가 비어도 단어를 남김)
+//   WEXP_CMD 명령어 WEXP_END  : $(...) (WEXP_QCMD는 큰따옴표 안)
+// 식은 $와 중괄호를 뺀 본문이다 (예: "HOME", "x:-default", "?").
+#define WEXP_PARAM  '\001'
+#define WEXP_QPARAM '\002'
+#define WEXP_END    '\003'
+#define WEXP_QEMPTY '\004'
+#define WEXP_CMD    '\005'
+#define WEXP_QCMD   '\006'
+
+#define SUBST_READ_BLOCK (64 * 1024)   // $(...) 출력을 읽을 때 최소 읽기 크기
+
+extern int expand_subst_status;        // 마지막 확장에서 실행한 $(...)의 종료 상태 (없으면 -1)
+
+// 확장된 단어들을 한 버퍼에 이어 붙여 만든다 (명령어마다 다시 할당하지 않고 재사용)
+typedef struct {
+    char *buf;                  // 단어들 ('\0'으로 구분)
+    size_t len, cap;
+    size_t *offs;               // 각 단어의 시작 오프셋
+    int count, offs_cap;
+    char **argv;                // offs를 포인터로 바꾼 결과 (NULL로 끝남)
+    int argv_cap;
+    Redirect *redirs;           // 파일 이름을 확장한 리다이렉션 사본
+    int redirs_cap;
+    size_t field_start;         // 만들고 있는 단어의 시작
+    int field_content;          // 만들고 있는 단어가 비어 있어도 남겨야 하면 1
+} ExpandBuf;
+
+int word_has_expansion(const char *word);
+// cmd의 인자와 리다이렉션 파일 이름을 확장해서 out에 담는다 (실패하면 -1, 메시지는 출력됨)
+int expand_command(Command *cmd, Command *out, ExpandBuf *eb);
+// 단어 목록을 확장한 argv (for 목록 등). 실패하면 NULL
+char **expand_words(ExpandBuf *eb, char **words);
+// heredoc 본문을 확장한 내용 (eb 안, 또는 확장할 것이 없으면 본문 그대로). 실패하면 NULL
+const char *expand_heredoc(ExpandBuf *eb, const Redirect *r, size_t *len);
+void expand_buf_free(ExpandBuf *eb);
+
+ExpandBuf *expand_acquire(void);   // 중첩 깊이마다 하나씩 재사용되는 버퍼
+void expand_release(void);
+void expand_reset_status(void);   // expand_subst_status를 -1로
+
+#endif // EXPAND_H
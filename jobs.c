@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "jobs.h"
+#include "builtins.h"
+
+static Job *jobs = NULL;        // 번호 순서대로 (마지막이 현재 작업 %+)
+static int job_count = 0;
+static int job_cap = 0;
+static int interactive = 0;
+static pid_t shell_pgid = 0;    // 작업이 끝나면 터미널을 돌려받을 쉘의 프로세스 그룹
+static volatile sig_atomic_t jobs_changed = 0;   // 알릴 것이 생겼으면 1
+
+// 작업 하나의 상태 변화를 거둔다. options에 WNOHANG이 없으면 바뀔 때까지 기다림
+static void reap_job(Job *job, int options) {
+    int st;
+    pid_t r;
+
+    if (job->state == JOB_DONE) return;
+    while ((r = waitpid(job->pid, &st, options | WUNTRACED | WCONTINUED)) < 0 && errno == EINTR)
+        ;
+    if (r < 0 && errno == ECHILD) {      // 이미 다른 곳에서 거둠: 상태를 알 수 없음
+        job->state = JOB_DONE;
+        job->status = 0;
+        jobs_changed = 1;
+        return;
+    }
+    if (r != job->pid) return;
+
+    if (WIFCONTINUED(st)) {
+        job->state = JOB_RUNNING;
+    } else if (WIFSTOPPED(st)) {
+        job->state = JOB_STOPPED;
+        job->status = st;
+    } else {
+        job->state = JOB_DONE;
+        job->status = st;
+    }
+    jobs_changed = 1;
+}
+
+static void on_sigchld(int sig) {
+    (void)sig;
+    int saved_errno = errno;
+    for (int i = 0; i < job_count; i++) reap_job(&jobs[i], WNOHANG);
+    errno = saved_errno;
+}
+
+static void block_sigchld(sigset_t *old) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &set, old);
+}
+
+static void restore_mask(const sigset_t *old) {
+    sigprocmask(SIG_SETMASK, old, NULL);
+}
+
+void jobs_init(int is_interactive) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigchld;
+    sa.sa_flags = SA_RESTART;    // fgets(), waitpid() 등이 EINTR로 끊기지 않도록
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGCHLD, &sa, NULL);
+    interactive = is_interactive;
+    shell_pgid = getpgrp();
+}
+
+int jobs_control(void) {
+    return interactive && isatty(STDIN_FILENO);
+}
+
+// 터미널의 포그라운드 그룹을 바꾼다. 쉘이 백그라운드 그룹일 때 부르면 SIGTTOU가 오므로 막아 둔다
+static void give_terminal(pid_t pgid) {
+    sigset_t set, old;
+    sigemptyset(&set);
+    sigaddset(&set, SIGTTOU);
+    sigprocmask(SIG_BLOCK, &set, &old);
+    if (tcsetpgrp(STDIN_FILENO, pgid) < 0) perror("tcsetpgrp");
+    sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+// 작업 전체 (프로세스 그룹이 있으면 그룹)에 시그널을 보낸다
+static void signal_job(const Job *job, int sig) {
+    if (job->pgid > 0) kill(-job->pgid, sig);
+    else kill(job->pid, sig);
+}
+
+static void remove_job(int i) {
+    free(jobs[i].text);
+    memmove(&jobs[i], &jobs[i + 1], (job_count - i - 1) * sizeof(Job));
+    job_count--;
+}
+
+// SIGCHLD를 막은 상태에서 호출
+static void remove_done_jobs(void) {
+    for (int i = job_count - 1; i >= 0; i--) {
+        if (jobs[i].state == JOB_DONE) remove_job(i);
+    }
+}
+
+int jobs_add(pid_t pid, const char *text, int len) {
+    sigset_t old;
+    block_sigchld(&old);
+
+    // 스크립트에서는 wait가 상태를 가져갈 수 있도록 끝난 작업도 남겨 두고, 표가 찼을 때만 정리
+    if (job_count >= job_cap && !interactive) remove_done_jobs();
+    if (job_count >= job_cap) {
+        int new_cap = job_cap ? job_cap * 2 : JOBS_INITIAL_CAP;
+        Job *grown = realloc(jobs, new_cap * sizeof(Job));
+        if (!grown) {
+            perror("jobs");
+            restore_mask(&old);
+            return 0;
+        }
+        jobs = grown;
+        job_cap = new_cap;
+    }
+
+    while (len > 0 && isspace((unsigned char)text[len - 1])) len--;
+    Job *job = &jobs[job_count++];
+    job->id = job_count > 1 ? jobs[job_count - 2].id + 1 : 1;
+    job->pid = pid;
+    job->pgid = jobs_control() ? pid : 0;   // execute_background()가 setpgid(pid, pid) 해 둠
+    job->state = JOB_RUNNING;
+    job->status = 0;
+    job->text = strndup(text ? text : "", len);
+    // 등록하기 전에 이미 끝났으면 SIGCHLD를 놓쳤으므로 한 번 확인
+    reap_job(job, WNOHANG);
+    int id = job->id;
+    restore_mask(&old);
+
+    if (interactive) err_printf("[%d] %d\n", id, (int)pid);
+    return id;
+}
+
+static int job_exit_code(const Job *job) {
+    if (job->state == JOB_STOPPED) return 128 + WSTOPSIG(job->status);
+    if (WIFSIGNALED(job->status)) return 128 + WTERMSIG(job->status);
+    return WEXITSTATUS(job->status);
+}
+
+static void print_job(int i, int show_pid) {
+    const Job *job = &jobs[i];
+    char state[32];
+    char marker = (i == job_count - 1) ? '+' : (i == job_count - 2) ? '-' : ' ';
+
+    if (job->state == JOB_RUNNING) {
+        snprintf(state, sizeof(state), "Running");
+    } else if (job->state == JOB_STOPPED) {
+        snprintf(state, sizeof(state), "Stopped");
+    } else if (WIFSIGNALED(job->status)) {
+        snprintf(state, sizeof(state), "%s", strsignal(WTERMSIG(job->status)));
+    } else if (WEXITSTATUS(job->status) != 0) {
+        snprintf(state, sizeof(state), "Exit %d", WEXITSTATUS(job->status));
+    } else {
+        snprintf(state, sizeof(state), "Done");
+    }
+
+    out_printf("[%d]%c  ", job->id, marker);
+    if (show_pid) out_printf("%d ", (int)job->pid);
+    out_printf("%-24s%s%s\n", state, job->text, job->state == JOB_RUNNING ? " &" : "");
+}
+
+void jobs_notify(void) {
+    if (!interactive || !jobs_changed) return;
+
+    sigset_t old;
+    block_sigchld(&old);
+    jobs_changed = 0;
+    for (int i = 0; i < job_count; i++) {
+        if (jobs[i].state == JOB_DONE) print_job(i, 0);
+    }
+    remove_done_jobs();
+    restore_mask(&old);
+    out_flush();
+}
+
+// %n, %+, %%, %-, 또는 pid로 작업을 찾는다 (없으면 -1). SIGCHLD를 막은 상태에서 호출
+static int find_job(const char *spec) {
+    if (job_count == 0) return -1;
+    if (spec[0] == '%') {
+        if (strcmp(spec, "%%") == 0 || strcmp(spec, "%+") == 0 || spec[1] == '\0') return job_count - 1;
+        if (strcmp(spec, "%-") == 0) return job_count >= 2 ? job_count - 2 : -1;
+        int id = atoi(spec + 1);
+        for (int i = 0; i < job_count; i++) {
+            if (jobs[i].id == id) return i;
+        }
+        return -1;
+    }
+    pid_t pid = (pid_t)atoi(spec);
+    for (int i = 0; i < job_count; i++) {
+        if (jobs[i].pid == pid) return i;
+    }
+    return -1;
+}
+
+// 작업이 끝나거나 멈출 때까지 기다린다. SIGCHLD를 막은 상태에서 호출
+static int wait_job(int i) {
+    while (jobs[i].state == JOB_RUNNING) reap_job(&jobs[i], 0);
+    return job_exit_code(&jobs[i]);
+}
+
+// jobs [-l|-p]
+int builtin_jobs(char **args) {
+    int show_pid = 0, only_pid = 0;
+    for (int i = 1; args[i]; i++) {
+        if (strcmp(args[i], "-l") == 0) show_pid = 1;
+        else if (strcmp(args[i], "-p") == 0) only_pid = 1;
+        else {
+            err_printf("jobs: %s: invalid option\n", args[i]);
+            return 2;
+        }
+    }
+
+    sigset_t old;
+    block_sigchld(&old);
+    for (int i = 0; i < job_count; i++) {
+        if (only_pid) out_printf("%d\n", (int)jobs[i].pid);
+        else print_job(i, show_pid);
+    }
+    if (!only_pid) remove_done_jobs();   // 알린 작업은 지움
+    jobs_changed = 0;
+    restore_mask(&old);
+    return 0;
+}
+
+// wait [%n | pid ...]: 인자가 없으면 모든 작업을 기다림
+int builtin_wait(char **args) {
+    int status = 0;
+    sigset_t old;
+
+    out_flush();
+    block_sigchld(&old);
+    if (!args[1]) {
+        for (int i = 0; i < job_count; i++) wait_job(i);
+        remove_done_jobs();
+        restore_mask(&old);
+        return 0;
+    }
+
+    for (int a = 1; args[a]; a++) {
+        int i = find_job(args[a]);
+        if (i >= 0) {
+            status = wait_job(i);
+            if (jobs[i].state == JOB_DONE) remove_job(i);
+            continue;
+        }
+        if (args[a][0] != '%' && isdigit((unsigned char)args[a][0])) {
+            // 표에서 정리된 자식일 수도 있으니 직접 기다려 본다
+            int st;
+            pid_t r;
+            while ((r = waitpid((pid_t)atoi(args[a]), &st, 0)) < 0 && errno == EINTR)
+                ;
+            if (r > 0) {
+                status = WIFSIGNALED(st) ? 128 + WTERMSIG(st) : WEXITSTATUS(st);
+                continue;
+            }
+            err_printf("wait: pid %s is not a child of this shell\n", args[a]);
+        } else {
+            err_printf("wait: %s: no such job\n", args[a]);
+        }
+        status = 127;
+    }
+    restore_mask(&old);
+    return status;
+}
+
+// fg [%n]: 작업을 이어서 실행하고 끝날 때까지 기다림
+int builtin_fg(char **args) {
+    sigset_t old;
+
+    out_flush();
+    block_sigchld(&old);
+    int i = args[1] ? find_job(args[1]) : job_count - 1;
+    if (i < 0) {
+        restore_mask(&old);
+        err_printf("fg: %s: no such job\n", args[1] ? args[1] : "current");
+        return 1;
+    }
+
+    Job *job = &jobs[i];
+    out_printf("%s\n", job->text);
+    out_flush();
+    int handoff = job->pgid > 0 && job->state != JOB_DONE;
+    if (handoff) give_terminal(job->pgid);   // Ctrl-C/Ctrl-Z가 이제 작업으로 감
+    if (job->state == JOB_STOPPED) {
+        signal_job(job, SIGCONT);
+        job->state = JOB_RUNNING;
+    }
+    int status = wait_job(i);
+    if (handoff) give_terminal(shell_pgid);
+    if (jobs[i].state == JOB_DONE) {
+        remove_job(i);
+    } else {
+        out_printf("\n");
+        print_job(i, 0);
+    }
+    restore_mask(&old);
+    return status;
+}
+
+// bg [%n]: 멈춘 작업을 백그라운드에서 이어서 실행
+int builtin_bg(char **args) {
+    sigset_t old;
+    block_sigchld(&old);
+    int i = args[1] ? find_job(args[1]) : job_count - 1;
+    if (i < 0) {
+        restore_mask(&old);
+        err_printf("bg: %s: no such job\n", args[1] ? args[1] : "current");
+        return 1;
+    }
+
+    Job *job = &jobs[i];
+    int status = 0;
+    if (job->state == JOB_DONE) {
+        err_printf("bg: job %d has already completed\n", job->id);
+        status = 1;
+    } else {
+        if (job->state == JOB_STOPPED) {
+            signal_job(job, SIGCONT);
+            job->state = JOB_RUNNING;
+        }
+        out_printf("[%d]%c %s &\n", job->id, i == job_count - 1 ? '+' : '-', job->text);
+    }
+    restore_mask(&old);
+    return status;
+}
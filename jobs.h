@@ -0,0 +1,36 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <sys/types.h>
+
+// 백그라운드 작업 표.
+// fork/spawn할 때 작업을 등록하고, SIGCHLD 핸들러가 등록된 pid만 WNOHANG으로 거둬
+// 종료 상태를 표에 적어 둔다 (포그라운드 명령어의 waitpid()와 겹치지 않음).
+// 표를 고치는 쪽은 SIGCHLD를 막은 상태에서만 고친다.
+// 대화형에서는 작업마다 자기 프로세스 그룹을 두어 터미널의 Ctrl-C/Ctrl-Z가 가지 않게 하고,
+// fg는 그 그룹에 터미널을 넘겨주었다가 기다린 뒤 쉘로 되찾는다.
+
+#define JOBS_INITIAL_CAP 16
+
+typedef enum { JOB_RUNNING, JOB_STOPPED, JOB_DONE } JobState;
+
+typedef struct {
+    int id;                  // %1, %2, ...
+    pid_t pid;
+    pid_t pgid;              // 작업의 프로세스 그룹 (작업 제어가 꺼져 있으면 0)
+    JobState state;
+    int status;              // waitpid()가 돌려준 상태 (JOB_DONE, JOB_STOPPED일 때)
+    char *text;              // 명령어 원문 (jobs 출력용)
+} Job;
+
+void jobs_init(int interactive);                   // SIGCHLD 핸들러 설치. 대화형이면 알림과 작업 제어
+int jobs_control(void);                            // 작업 제어 (작업마다 프로세스 그룹)가 켜져 있으면 1
+int jobs_add(pid_t pid, const char *text, int len);  // 작업 번호를 돌려줌
+void jobs_notify(void);                            // 끝난 작업을 알리고 표에서 지움 (프롬프트 전에)
+
+int builtin_jobs(char **args);
+int builtin_wait(char **args);
+int builtin_fg(char **args);
+int builtin_bg(char **args);
+
+#endif // JOBS_H
@@ -2,74 +2,330 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
-#include <pwd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "tokenizer.h"
 #include "parser.h"
 #include "executer.h"
-void show_prompt() {
-    char hostname[1024];
-    char cwd[1024];
-    char* home;
-    struct passwd* pw;
-
-    pw = getpwuid(geteuid());
-    if (pw == NULL) {
-        perror("getpwuid 실패");
-        return;
+#include "prompt.h"
+#include "vars.h"
+#include "jobs.h"
+#include "stats.h"
+
+extern char **environ;
+
+#define SCRIPT_READ_BLOCK (1024 * 1024)   // 파이프에서 스크립트를 읽는 블록 크기
+#define BATCH_READ_BLOCK (64 * 1024)      // stdin에서 미리 읽는 블록 크기
+
+// 스크립트 파일을 mmap한다. 파일 뒤에 0으로 채워진 페이지를 하나 더 두어
+// 복사 없이도 버퍼가 항상 '\0'으로 끝나도록 한다.
+static char *map_script(int fd, size_t size, size_t *map_len) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t len = (size / page + 1) * page;
+
+    char *base = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+    if (size > 0 && mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, len);
+        return NULL;
     }
+    madvise(base, len, MADV_SEQUENTIAL);
+    *map_len = len;
+    return base;
+}
+
+// 파이프처럼 mmap할 수 없는 입력은 큰 블록 단위로 한 버퍼에 읽어 들인다
+static char *read_script(int fd, size_t *size) {
+    size_t cap = SCRIPT_READ_BLOCK, len = 0;
+    char *buf = malloc(cap + 1);
+    if (!buf) return NULL;
 
-    if (gethostname(hostname, sizeof(hostname)) != 0) {
-        perror("gethostname 실패");
-        return;
+    while (1) {
+        if (cap - len < SCRIPT_READ_BLOCK) {
+            char *grown = realloc(buf, cap * 2 + 1);
+            if (!grown) { free(buf); return NULL; }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, buf + len, cap - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) { free(buf); return NULL; }
+        if (n == 0) break;
+        len += n;
     }
+    buf[len] = '\0';
+    *size = len;
+    return buf;
+}
+
+// 입력 버퍼 하나를 통째로 토큰화해서 실행 (buf는 '\0'으로 끝나야 함)
+static void run_buffer(const char *buf) {
+    Arena parse_arena = { 0 };
+    TokenList tokens = { 0 };
+    STATS_BEGIN(t0);
+    int result = tokenize(&tokens, buf);
+    STATS_END(STAT_TOKENIZE, t0);
+
+    TokenStream stream = {
+        .tokens = tokens.data,
+        .count = tokens.count,
+        .pos = 0,
+        .src = buf,
+        .arena = &parse_arena
+    };
+    execute_tokens(&stream);
+    out_flush();
+    if (result < 0) last_status = 2;     // 닫히지 않은 따옴표 등: 앞의 명령어만 실행됨
+
+    arena_free(&parse_arena);
+    free_tokens(&tokens);
+}
 
-    if (getcwd(cwd, sizeof(cwd)) == NULL) {
-        perror("getcwd 실패");
-        return;
+// MONGSHELL script.sh [args] : 프롬프트 없이 스크립트 전체를 한 번에 토큰화해서 실행
+static int run_script(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(path);
+        return 127;
     }
 
-    home = getenv("HOME");
-    if (home != NULL && strstr(cwd, home) == cwd) {
-        printf("%s@%s:~%s$ ", pw->pw_name, hostname, cwd + strlen(home));
-    } else {
-        printf("%s@%s:%s$ ", pw->pw_name, hostname, cwd);
+    struct stat st;
+    char *script = NULL;
+    size_t size = 0, map_len = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        size = st.st_size;
+        script = map_script(fd, size, &map_len);
     }
+    if (!script) {
+        script = read_script(fd, &size);
+        map_len = 0;
+    }
+    close(fd);
+    if (!script) {
+        perror(path);
+        return 1;
+    }
+
+    run_buffer(script);
+    if (map_len) munmap(script, map_len);
+    else free(script);
+    return last_status;
+}
+
+// 토큰화를 마친 입력 버퍼를 실행한다
+static void run_tokens(TokenList *tokens, const char *buf, Arena *parse_arena) {
+    STATS_BEGIN(t0);
+    int result = tokenize_finish(tokens);
+    STATS_END(STAT_TOKENIZE, t0);
+
+    TokenStream stream = {
+        .tokens = tokens->data,
+        .count = tokens->count,
+        .pos = 0,
+        .src = buf,
+        .arena = parse_arena
+    };
+    execute_tokens(&stream);
+    out_flush();
+    if (result < 0) last_status = 2;
 }
 
-int main() {
-    char command[1024];
+// stdin에서 명령어를 읽는 쪽. 명령어가 실행되는 동안 자식도 같은 stdin을 읽을 수 있으므로
+// (printf 'cat\nhello\n' | MONGSHELL) 실행 전에 쉘이 명령어 뒤의 입력을 가져가 버리면 안 된다.
+// 파일처럼 되감을 수 있으면 블록으로 읽고 실행 전에 명령어 끝으로 lseek한다.
+// 파이프는 되감을 수 없지만 한 바이트씩 read()하면 큰 입력에서 시스템 콜이 바이트 수만큼 늘어나므로
+// 역시 블록으로 읽는다. 그래서 파이프에서는 쉘이 미리 읽은 부분을 자식이 보지 못한다
+// (위 예에서 hello는 cat이 아니라 쉘이 명령어로 실행함. dash도 같다).
+// 명령어와 자식이 읽을 데이터를 한 파이프에 섞어 보내려면 파일로 넘기거나 (MONGSHELL < file)
+// 데이터를 heredoc으로 넘기면 된다.
+typedef struct {
+    int fd;
+    int seekable;
+    char *buf;              // 미리 읽어 둔 블록
+    size_t len, pos;
+    off_t base;             // buf[0]의 파일 오프셋 (seekable일 때만)
+} BatchInput;
 
+// 한 줄을 (줄바꿈 포함) *line 뒤에 붙인다. 읽은 바이트 수, EOF면 0, 오류면 -1
+static ssize_t batch_read_line(BatchInput *in, char **line, size_t *len, size_t *cap) {
+    size_t start = *len;
     while (1) {
-        show_prompt();
+        if (in->pos == in->len) {
+            ssize_t n = in->seekable
+                ? pread(in->fd, in->buf, BATCH_READ_BLOCK, in->base + in->len)
+                : read(in->fd, in->buf, BATCH_READ_BLOCK);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return -1;
+            in->base += in->len;
+            in->len = n;
+            in->pos = 0;
+            if (n == 0) break;
+        }
 
-        if (fgets(command, sizeof(command), stdin) == NULL) {
-            printf("\n");
-            break;
+        // 블록 안에서 줄 끝까지 한 번에 복사
+        const char *p = in->buf + in->pos;
+        const char *nl = memchr(p, '\n', in->len - in->pos);
+        size_t take = nl ? (size_t)(nl - p) + 1 : in->len - in->pos;
+        if (*cap - *len < take + 1) {
+            size_t new_cap = *cap ? *cap : 4096;
+            while (new_cap - *len < take + 1) new_cap *= 2;
+            char *grown = realloc(*line, new_cap);
+            if (!grown) return -1;
+            *line = grown;
+            *cap = new_cap;
         }
+        memcpy(*line + *len, p, take);
+        *len += take;
+        in->pos += take;
+        if (nl) break;
+    }
+    if (*line) (*line)[*len] = '\0';
+    return *len - start;
+}
 
-        command[strcspn(command, "\n")] = 0;
+// stdin이 터미널이 아닐 때: 프롬프트 없이 한 줄씩 모아 이어서 토큰화하고,
+// 따옴표, heredoc, 블록이 모두 닫히면 그 명령어를 실행한다.
+static int run_batch(int fd) {
+    BatchInput in = { .fd = fd };
+    char *command = NULL;
+    size_t command_len = 0, command_cap = 0;
+    Arena parse_arena = { 0 };
+    TokenList tokens = { 0 };
+    BlockScan blocks = { 0 };
+    ssize_t n;
 
-        if (strcmp(command, "exit") == 0) {
-            break;
+    in.base = lseek(fd, 0, SEEK_CUR);
+    in.seekable = in.base >= 0;
+    if (!(in.buf = malloc(BATCH_READ_BLOCK))) {
+        perror("malloc");
+        return 1;
+    }
+    tokenize_begin(&tokens);
+
+    while ((n = batch_read_line(&in, &command, &command_len, &command_cap)) > 0) {
+        STATS_BEGIN(t0);
+        int complete = tokenize_feed(&tokens, command, command_len);
+        STATS_END(STAT_TOKENIZE, t0);
+        if (!complete || tokens_incomplete(&tokens, &blocks)) continue;
+
+        // 자식이 stdin을 이어서 읽을 수 있도록 파일 위치를 이 명령어 끝으로
+        off_t next = in.base + in.pos;
+        if (in.seekable) lseek(fd, next, SEEK_SET);
+        run_tokens(&tokens, command, &parse_arena);
+        if (in.seekable) {
+            off_t now = lseek(fd, 0, SEEK_CUR);
+            if (now != next) {      // 명령어가 stdin을 읽었음: 미리 읽은 블록은 버림
+                in.base = now;
+                in.len = in.pos = 0;
+            }
+        }
+
+        command_len = 0;
+        tokenize_begin(&tokens);
+        memset(&blocks, 0, sizeof(blocks));
+    }
+    if (n < 0) perror("read");
+    if (command_len > 0) {          // 닫히지 않은 채 끝난 입력
+        if (in.seekable) lseek(fd, in.base + in.pos, SEEK_SET);
+        run_tokens(&tokens, command, &parse_arena);
+    }
+
+    arena_free(&parse_arena);
+    free_tokens(&tokens);
+    free(command);
+    free(in.buf);
+    return last_status;
+}
+
+int main(int argc, char *argv[]) {
+    char *command = NULL;        // 여러 줄에 걸친 명령어를 모으는 버퍼
+    size_t command_len = 0, command_cap = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    Arena parse_arena = { 0 };   // 한 줄의 파싱 결과를 담는 arena (줄마다 재사용)
+    TokenList tokens = { 0 };    // 입력 버퍼를 가리키는 토큰 배열 (줄마다 재사용)
+
+    vars_init(environ);
+    stats_init();
+    shell_pid = getpid();
+
+    // MONGSHELL -c '명령어' [$0 [$1 ...]]
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "%s: -c: option requires an argument\n", argv[0]);
+            return 2;
+        }
+        shell_argc = argc > 3 ? argc - 3 : 1;
+        shell_argv = argc > 3 ? argv + 3 : argv;
+        jobs_init(0);
+        run_buffer(argv[2]);
+        return last_status;
+    }
+    if (argc > 1) {
+        shell_argc = argc - 1;   // $0 = 스크립트 경로, $1... = 나머지 인자
+        shell_argv = argv + 1;
+        jobs_init(0);
+        return run_script(argv[1]);
+    }
+    shell_argc = 1;
+    shell_argv = argv;
+    if (!isatty(STDIN_FILENO)) {   // 파이프나 파일에서 오는 명령어
+        jobs_init(0);
+        return run_batch(STDIN_FILENO);
+    }
+    prompt_init();
+    jobs_init(1);
+
+    while (1) {
+        jobs_notify();
+        show_prompt();
+
+        // 따옴표, heredoc, 블록이 닫힐 때까지 PS2를 보여 주며 줄을 더 읽는다.
+        // 토큰화는 새 줄만 이어서 한다.
+        BlockScan blocks = { 0 };
+        int eof = 0;
+        command_len = 0;
+        tokenize_begin(&tokens);
+        while (1) {
+            ssize_t n = getline(&line, &line_cap, stdin);
+            if (n < 0) {
+                eof = 1;
+                break;
+            }
+            if (command_len + n + 1 > command_cap) {
+                size_t new_cap = command_cap ? command_cap * 2 : 1024;
+                while (new_cap < command_len + n + 1) new_cap *= 2;
+                char *grown = realloc(command, new_cap);
+                if (!grown) {
+                    perror("realloc");
+                    eof = 1;
+                    break;
+                }
+                command = grown;
+                command_cap = new_cap;
+            }
+            memcpy(command + command_len, line, n + 1);
+            command_len += n;
+
+            STATS_BEGIN(t0);
+            int complete = tokenize_feed(&tokens, command, command_len);
+            STATS_END(STAT_TOKENIZE, t0);
+            if (complete && !tokens_incomplete(&tokens, &blocks)) break;
+            show_continuation_prompt();
         }
 
-        token_count = 0;
-        tokenize(command);
-        
-
-        TokenStream stream = {
-            .tokens = tokens,
-            .count = token_count,
-            .pos = 0
-        };
-
-        Command *cmd = parse_command(&stream);
-        if (cmd) {
-            
-            execute_command(cmd);        // 실제 명령 실행
-            free_command(cmd);
+        if (command_len > 0) run_tokens(&tokens, command, &parse_arena);
+        if (eof) {
+            printf("\n");
+            break;
         }
     }
 
+    free(line);
+    free(command);
+    arena_free(&parse_arena);
+    free_tokens(&tokens);
     return 0;
 }
@@ -1,71 +1,200 @@
 #include "tokenizer.h"
 #include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include "parser.h"
+#include "arena.h"
+#include "expand.h"
 
 Command *parse_simple(TokenStream *stream);
 Command *parse_command(TokenStream *stream);
 Command *parse_pipeline(TokenStream *stream);
 Command *parse_sequence(TokenStream *stream);
 Command *parse_sequence_until(TokenStream *stream, const char *end_token);
+Command *parse_until(TokenStream *stream, const char *end_token);
 Command *parse_logical(TokenStream *stream);
 
+// 토큰이 가리키는 입력 조각이 value와 같은지
+static bool tok_is(TokenStream *stream, Token *tok, const char *value) {
+    return token_equals(stream->src, tok, value);
+}
+
+// 파서가 소유해야 하는 문자열만 arena로 복사
+static char *tok_dup(TokenStream *stream, Token *tok) {
+    return arena_strndup(stream->arena, stream->src + tok->start, tok->len);
+}
+
+// 주석 토큰은 파서에서 보이지 않도록 건너뛴다
+static void skip_comments(TokenStream *stream) {
+    while (stream->pos < stream->count && stream->tokens[stream->pos].type == T_COMMENT)
+        stream->pos++;
+}
+
 Token *next_token(TokenStream *stream) {
+    skip_comments(stream);
     if (stream->pos >= stream->count)
         return NULL;
     return &stream->tokens[stream->pos++];
 }
 
 Token *peek_token(TokenStream *stream) {
+    skip_comments(stream);
     if (stream->pos >= stream->count)
         return NULL;
     return &stream->tokens[stream->pos];
 }
 
+// 줄바꿈 토큰 (스크립트에서 명령어를 구분)
+static bool is_newline(TokenStream *stream, Token *tok) {
+    return tok && tok->type == T_OPERATOR && tok_is(stream, tok, "\n");
+}
+
+// 명령어 구분자: ';' 또는 줄바꿈
+static bool is_separator(TokenStream *stream, Token *tok) {
+    return tok && tok->type == T_OPERATOR && (tok_is(stream, tok, ";") || tok_is(stream, tok, "\n"));
+}
+
+static void skip_newlines(TokenStream *stream) {
+    while (is_newline(stream, peek_token(stream)))
+        next_token(stream);
+}
+
+// 복합 명령어 본문을 끝내는 예약어인지 (then, else, fi, do, done, }, ))
+static bool is_block_end(TokenStream *stream, Token *tok, const char *end_token) {
+    static const char *reserved[] = { "then", "else", "fi", "do", "done", "}", NULL };
+    if (!tok) return true;
+    if (tok->type == T_EOF) return true;
+    if (tok->type == T_PAREN) return tok_is(stream, tok, ")");
+    if (tok->type != T_WORD) return false;
+    if (end_token && tok_is(stream, tok, end_token)) return true;
+    for (int i = 0; reserved[i]; i++) {
+        if (tok_is(stream, tok, reserved[i])) return true;
+    }
+    return false;
+}
+
 bool match_token(TokenStream *stream, const char *value) {
     Token *tok = peek_token(stream);
-    if (tok && strcmp(tok->value, value) == 0) {
+    if (tok && tok_is(stream, tok, value)) {
         next_token(stream);
         return true;
     }
     return false;
 }
 
-int split_tokens(Token *tokens, int count, const char *sep) {
+int split_tokens(const char *src, Token *tokens, int count, const char *sep) {
     for (int i = 0; i < count; i++) {
-        if (strcmp(tokens[i].value, sep) == 0)
+        if (token_equals(src, &tokens[i], sep))
             return i;
     }
     return -1;  // 못 찾으면 -1
 }
 
-void free_redirects(Redirect *redir) {
-    while (redir) {
-        Redirect *next = redir->next;
-        free(redir->op);
-        if (redir->file) free(redir->file);
-        free(redir);
-        redir = next;
-    }
+// arena에서 0으로 초기화된 Command 노드를 할당
+static Command *new_command(TokenStream *stream, CommandType type) {
+    Command *cmd = arena_calloc(stream->arena, sizeof(Command));
+    cmd->type = type;
+    return cmd;
 }
 
-void free_command(Command *cmd) {
-    if (!cmd) return;
-
-    free_command(cmd->left);
-    free_command(cmd->right);
-    free_command(cmd->condition);
-    free_command(cmd->then_block);
-    free_command(cmd->else_block);
+// 현재 위치부터 인자가 될 수 있는 토큰 수 (args 배열 크기 계산용, 상한값)
+static int count_arg_tokens(TokenStream *stream) {
+    int n = 0;
+    for (int i = stream->pos; i < stream->count; i++) {
+        Token *tok = &stream->tokens[i];
+        if (token_is_wordpart(tok))
+            n++;
+        else if (!(tok->type == T_OPERATOR && is_redirect_operator(stream->src + tok->start, tok->len)) &&
+                 tok->type != T_HEREDOC)
+            break;
+    }
+    return n;
+}
 
-    for (int i = 0; cmd->args[i]; i++)
-        free(cmd->args[i]);
+// 토큰 하나를 단어 틀에 옮긴다 (따옴표 제거, 이스케이프 처리, 확장 표시)
+static char *put_word_part(const char *src, Token *tok, char *out) {
+    const char *s = src + tok->start;
+    const char *end = s + tok->len;
+
+    switch (tok->type) {
+        case T_VARIABLE:
+            // $name → name, ${body} → body
+            *out++ = (tok->flags & TF_DQUOTE) ? WEXP_QPARAM : WEXP_PARAM;
+            s++;
+            if (*s == '{') {
+                s++;
+                if (end > s && end[-1] == '}') end--;
+            }
+            memcpy(out, s, end - s);
+            out += end - s;
+            *out++ = WEXP_END;
+            return out;
+
+        case T_STRING:
+            if (!(tok->flags & TF_DQUOTE)) {     // 작은따옴표: 그대로
+                memcpy(out, s, end - s);
+                return out + (end - s);
+            }
+            // 큰따옴표: \$ \` \" \\ 와 줄 이음만 이스케이프
+            for (; s < end; s++) {
+                if (*s == '\\' && s + 1 < end && strchr("$`\"\\\n", s[1])) {
+                    s++;
+                    if (*s == '\n') continue;
+                }
+                *out++ = *s;
+            }
+            return out;
+
+        case T_WORD:
+            for (; s < end; s++) {
+                if (*s == '\\' && s + 1 < end) {
+                    s++;
+                    if (*s == '\n') continue;
+                }
+                *out++ = *s;
+            }
+            return out;
 
-    free_redirects(cmd->redirects);
+        case T_COMMAND_SUB:
+            // $(cmd) → cmd
+            *out++ = (tok->flags & TF_DQUOTE) ? WEXP_QCMD : WEXP_CMD;
+            memcpy(out, s + 2, tok->len - 3);
+            out += tok->len - 3;
+            *out++ = WEXP_END;
+            return out;
 
-    if (cmd->heredoc_body)
-        free(cmd->heredoc_body);
+        default:                                 // 패턴은 글자 그대로
+            memcpy(out, s, end - s);
+            return out + (end - s);
+    }
+}
 
-    free(cmd);
+// 공백 없이 이어진 토큰들을 하나의 인자로 합친다.
+// 확장할 것이 있으면 *expand를 1로 만들고, 틀에는 확장 표시가 들어간다.
+static char *parse_word(TokenStream *stream, int *expand) {
+    int first = stream->pos, last = first;
+    size_t size = 2;
+    int has_param = 0, quoted = 0;
+
+    while (last < stream->count) {
+        Token *tok = &stream->tokens[last];
+        if (!token_is_wordpart(tok) || (last > first && !(tok->flags & TF_JOINED))) break;
+        size += tok->len + 2;
+        if (tok->type == T_VARIABLE || tok->type == T_COMMAND_SUB) has_param = 1;
+        if (tok->type == T_STRING) quoted = 1;
+        last++;
+    }
+
+    char *word = arena_alloc(stream->arena, size);
+    char *out = word;
+    if (has_param && quoted) *out++ = WEXP_QEMPTY;   // "$x"가 비어도 인자는 남김
+    for (int i = first; i < last; i++)
+        out = put_word_part(stream->src, &stream->tokens[i], out);
+    *out = '\0';
+
+    stream->pos = last;
+    if (has_param && expand) *expand = 1;
+    return word;
 }
 
 int needs_filename(const char *op) {
@@ -76,7 +205,7 @@ int needs_filename(const char *op) {
 
     if (*p == '>' || *p == '<') {
         if (*(p + 1) == '&') {
-            return 0;  // FD 이동 (예: 2>&1) → 파일명 불필요
+            return p[2] == '\0';  // FD 이동 (예: 2>&1) → 파일명 불필요. >& 1, >& file 은 다음 단어가 대상
         }
         return 1;      // FD + > 또는 < (예: 2> file) → 파일 필요
     }
@@ -91,47 +220,111 @@ int needs_filename(const char *op) {
     return 0;          // 그 외 → 파일 불필요
 }
 
+// 리다이렉션 목록 끝에 붙인다 (적용 순서 = 나온 순서)
+static void append_redirect(Command *cmd, Redirect *redir) {
+    if (!cmd->redirects) {
+        cmd->redirects = redir;
+    } else {
+        Redirect *cur = cmd->redirects;
+        while (cur->next)
+            cur = cur->next;
+        cur->next = redir;
+    }
+}
+
+// 단어 전체가 숫자면 그 값, 아니면 -1
+static int parse_fd_number(const char *s) {
+    if (!s || !isdigit((unsigned char)*s)) return -1;
+    long n = 0;
+    for (; *s; s++) {
+        if (!isdigit((unsigned char)*s) || n > 9999) return -1;
+        n = n * 10 + (*s - '0');
+    }
+    return (int)n;
+}
+
+// 연산자 문자열을 실행할 때 쓸 기록(종류, fd, 대상, open 플래그)으로 바꾼다
+static void compile_redirect(Redirect *redir) {
+    const char *op = redir->op;
+    const char *p = op;
+    while (isdigit((unsigned char)*p)) p++;
+
+    // 앞에 FD가 붙어있으면 그 번호, 없으면 < 는 STDIN, > 는 STDOUT
+    redir->fd = (p != op) ? atoi(op) : (*p == '<' ? STDIN_FILENO : STDOUT_FILENO);
+    redir->target_fd = -1;
+    redir->flags = 0;
+    redir->kind = REDIR_OPEN;
+
+    if (strcmp(p, "<") == 0) {
+        redir->flags = O_RDONLY;
+    } else if (strcmp(p, ">") == 0) {
+        redir->flags = O_WRONLY | O_CREAT | O_TRUNC;
+    } else if (strcmp(p, ">>") == 0) {
+        redir->flags = O_WRONLY | O_CREAT | O_APPEND;
+    } else if (strcmp(p, "<>") == 0) {
+        redir->flags = O_RDWR | O_CREAT;
+    } else if (strcmp(p, "&>") == 0 || strcmp(p, "&>>") == 0) {
+        // STDOUT, STDERR 모두 같은 파일로
+        redir->fd = STDOUT_FILENO;
+        redir->target_fd = STDERR_FILENO;
+        redir->flags = O_WRONLY | O_CREAT | (p[2] == '>' ? O_APPEND : O_TRUNC);
+    } else if (strcmp(p, "<<") == 0 || strcmp(p, "<<-") == 0) {
+        redir->kind = REDIR_HEREDOC;
+    } else if ((p[0] == '>' || p[0] == '<') && p[1] == '&') {
+        // n>&m, n>&-: 대상은 연산자 안에, n>& word: 다음 단어에
+        const char *target = p[2] ? p + 2 : redir->file;
+        int target_fd = parse_fd_number(target);
+        if (target && strcmp(target, "-") == 0) {
+            redir->kind = REDIR_CLOSE;
+        } else if (target_fd >= 0) {
+            redir->kind = REDIR_DUP;
+            redir->target_fd = target_fd;
+        } else if (p[0] == '>' && p == op && redir->file) {
+            // >& file 은 &> file 과 같음
+            redir->fd = STDOUT_FILENO;
+            redir->target_fd = STDERR_FILENO;
+            redir->flags = O_WRONLY | O_CREAT | O_TRUNC;
+        } else {
+            redir->kind = REDIR_UNSUPPORTED;
+        }
+    } else {
+        redir->kind = REDIR_UNSUPPORTED;
+    }
+    redir->flags |= O_CLOEXEC;   // dup2()한 사본만 자식에게 넘어간다
+}
+
 void parse_redirects(Command *cmd, TokenStream *stream) {
     Token *tok = next_token(stream);  // operator 소비
     if (!tok) return;
 
-    char *op = strdup(tok->value);    // 연산자 복사
+    char *op = tok_dup(stream, tok);    // 연산자 복사
     char *file = NULL;
 
     if (needs_filename(op)) {
-        Token *target = next_token(stream);
-        if (!target || target->type != T_WORD) {
+        Token *target = peek_token(stream);
+        if (!target || !token_is_wordpart(target)) {
             fprintf(stderr, "Error: expected filename after '%s'\n", op);
-            free(op);
             return;
         }
-        file = strdup(target->value);
+        file = parse_word(stream, &cmd->expand);
     }
 
-    Redirect *redir = malloc(sizeof(Redirect));
+    Redirect *redir = arena_calloc(stream->arena, sizeof(Redirect));
     redir->op = op;
     redir->file = file;
-    redir->next = NULL;
-
-    if (!cmd->redirects) {
-        cmd->redirects = redir;
-    } else {
-        Redirect *cur = cmd->redirects;
-        while (cur->next)
-            cur = cur->next;
-        cur->next = redir;
-    }
+    compile_redirect(redir);
+    append_redirect(cmd, redir);
 }
 
 Command *parse_background_cmd(Command *left, TokenStream *stream) {
     Token *tok = peek_token(stream);
-    if (!tok || tok->type != T_OPERATOR || strcmp(tok->value, "&") != 0)
+    if (!tok || tok->type != T_OPERATOR || !tok_is(stream, tok, "&"))
         return left;
 
     next_token(stream); // '&' 소비
 
     Token *next = peek_token(stream);
-    if (next && (next->type == T_OPERATOR && strcmp(next->value, ";") == 0)) {
+    if (next && (next->type == T_OPERATOR && tok_is(stream, next, ";"))) {
         fprintf(stderr, "Error: '&' must not be followed by ';'\n");
         return NULL;
     }
@@ -141,9 +334,7 @@ Command *parse_background_cmd(Command *left, TokenStream *stream) {
         return NULL;
     }
 
-    Command *cmd = malloc(sizeof(Command));
-    memset(cmd, 0, sizeof(Command));
-    cmd->type = CMD_BACKGROUND;
+    Command *cmd = new_command(stream, CMD_BACKGROUND);
     cmd->left = left;
     return cmd;
 }
@@ -152,67 +343,65 @@ Command *parse_background_cmd(Command *left, TokenStream *stream) {
 
 
 void parse_heredoc(Command *cmd, TokenStream *stream) {
-    Token *op = next_token(stream);  // << 연산자 소비
-    if (!op || strcmp(op->value, "<<") != 0) {
+    Token *op = next_token(stream);  // <<, <<- 연산자 소비
+    if (!op || op->type != T_HEREDOC) {
         fprintf(stderr, "Error: expected '<<'\n");
         return;
     }
+    int strip_tabs = (op->len == 3);
 
-    Token *delim_token = next_token(stream);  // delimiter 읽기 (예: EOF)
+    Token *delim_token = next_token(stream);  // delimiter 읽기 (예: EOF, 'EOF')
     if (!delim_token || delim_token->type != T_WORD) {
         fprintf(stderr, "Error: expected heredoc delimiter after '<<'\n");
         return;
     }
 
-    const char *delimiter = delim_token->value;
-
-    // 본문 수집
-    char buffer[4096] = {0};  // 최대 4KB 본문
-    size_t offset = 0;
-
-    while (true) {
-        char line[512];
-        if (!fgets(line, sizeof(line), stdin)) {
-            fprintf(stderr, "Error: unexpected EOF while reading heredoc\n");
-            return;  // [보완] 원래 break로 빠져나와서 아래 코드 진행 위험 → return으로 안전 종료
-        }
-
-        // 줄 끝 '\n' 제거
-        size_t len = strlen(line);
-        if (len > 0 && line[len - 1] == '\n')
-            line[--len] = '\0';
-
-        // 종료 식별자 확인
-        if (strcmp(line, delimiter) == 0)
-            break;
-
-        size_t total_needed = offset + len + 1 + 1;  // [보완] 기존 +2 계산이 불명확 → line + '\n' + '\0' 명확히 분리
-        if (total_needed >= sizeof(buffer)) {
-            fprintf(stderr, "Error: heredoc body too large\n");
-            return;  // [보완] break 대신 return으로 안전 종료
+    // 구분자의 따옴표를 벗기고, 따옴표가 있었으면 본문을 확장하지 않음
+    const char *raw = stream->src + delim_token->start;
+    char *delimiter = arena_alloc(stream->arena, delim_token->len + 1);
+    size_t dlen = 0;
+    int quoted = 0;
+    for (int i = 0; i < delim_token->len; i++) {
+        if (raw[i] == '\'' || raw[i] == '"' || raw[i] == '\\') {
+            quoted = 1;
+            if (raw[i] == '\\' && i + 1 < delim_token->len) delimiter[dlen++] = raw[++i];
+            continue;
         }
+        delimiter[dlen++] = raw[i];
+    }
+    delimiter[dlen] = '\0';
 
-        //  [보완] strcat 대신 memcpy + offset으로 직접 추가 → strcat 반복 사용은 느림(O(n²)) → memcpy로 개선
-        memcpy(buffer + offset, line, len);
-        offset += len;
+    Redirect *redir = arena_calloc(stream->arena, sizeof(Redirect));
+    redir->op = arena_strndup(stream->arena, stream->src + op->start, op->len);
+    compile_redirect(redir);
+    redir->heredoc_flags = (quoted ? 0 : HEREDOC_EXPAND) | (strip_tabs ? HEREDOC_STRIP_TABS : 0);
 
-        buffer[offset++] = '\n';  // 개행 추가
-        buffer[offset] = '\0';    // 널 종료 유지
+    // 본문은 토크나이저가 입력 버퍼 안에서 찾아 둔 조각을 그대로 쓴다
+    // (대화형에서도 본문 줄은 PS2로 더 읽어서 같은 버퍼에 들어 있음)
+    Token *body = peek_token(stream);
+    if (body && body->type == T_HEREDOC && (body->flags & TF_HEREDOC_BODY)) {
+        next_token(stream);
+        if (body->flags & TF_UNTERMINATED)
+            fprintf(stderr, "warning: here-document delimited by end-of-file (wanted `%s')\n", delimiter);
+        redir->body = stream->src + body->start;
+        redir->body_len = body->len;
+    } else {
+        redir->body = "";
+        redir->body_len = 0;
     }
-
-    cmd->heredoc_body = strdup(buffer);
+    append_redirect(cmd, redir);
 }
 
-int is_redirect_operator(const char *op) {
-    if (strcmp(op, ">") == 0 || strcmp(op, "<") == 0 ||
-        strcmp(op, ">>") == 0 || strcmp(op, "&>") == 0 ||
-        strcmp(op, "&>>") == 0 || strcmp(op, "<>") == 0)
+// op는 NUL로 끝나지 않는 입력 조각일 수 있으므로 길이로 판별
+int is_redirect_operator(const char *op, int len) {
+    // &>, &>>
+    if (len >= 2 && op[0] == '&' && op[1] == '>')
         return 1;
 
-    // FD 리다이렉션 패턴 (예: 2>, 123>&1)
-    const char *p = op;
-    while (isdigit(*p)) p++;
-    if (*p == '>' || *p == '<')
+    // >, <, >>, <> 와 FD 리다이렉션 패턴 (예: 2>, 123>&1)
+    const char *p = op, *end = op + len;
+    while (p < end && isdigit(*p)) p++;
+    if (p < end && (*p == '>' || *p == '<'))
         return 1;
     return 0;
 }
@@ -226,26 +415,24 @@ Command *parse_logical(TokenStream *stream) {
         if (!tok || tok->type != T_OPERATOR) break;
 
         CommandType type;
-        if (strcmp(tok->value, "&&") == 0) {
+        if (tok_is(stream, tok, "&&")) {
             type = CMD_AND;
-        } else if (strcmp(tok->value, "||") == 0) {
+        } else if (tok_is(stream, tok, "||")) {
             type = CMD_OR;
         } else {
             break;
         }
 
         next_token(stream);  // && 또는 || 소비
+        skip_newlines(stream);  // 연산자 뒤의 줄바꿈은 이어지는 줄로 취급
 
-        Command *right = parse_logical(stream);  // 재귀적으로 처리!
+        Command *right = parse_pipeline(stream);  // 왼쪽 결합: a && b || c == (a && b) || c
         if (!right) {
-            fprintf(stderr, "Error: expected command after '%s'\n", tok->value);
-            free_command(left);
+            fprintf(stderr, "Error: expected command after '%.*s'\n", tok->len, stream->src + tok->start);
             return NULL;
         }
 
-        Command *cmd = malloc(sizeof(Command));
-        memset(cmd, 0, sizeof(Command));
-        cmd->type = type;
+        Command *cmd = new_command(stream, type);
         cmd->left = left;
         cmd->right = right;
 
@@ -255,26 +442,84 @@ Command *parse_logical(TokenStream *stream) {
     return left;
 }
 
+// 복합 명령어 뒤의 리다이렉션 (done > out, } 2>&1, fi < in ...): 본문 전체에 한 번 적용
+static Command *parse_compound_redirects(Command *cmd, TokenStream *stream) {
+    Token *tok;
+    while (cmd && (tok = peek_token(stream)) != NULL) {
+        if (tok->type == T_OPERATOR && is_redirect_operator(stream->src + tok->start, tok->len)) {
+            parse_redirects(cmd, stream);
+        } else if (tok->type == T_HEREDOC) {
+            parse_heredoc(cmd, stream);
+        } else {
+            break;
+        }
+    }
+    return cmd;
+}
+
+// 예약어로 시작하면 복합 명령어로, 아니면 단순 명령어로 파싱
+Command *parse_compound_or_simple(TokenStream *stream) {
+    Token *tok = peek_token(stream);
+    if (tok && tok->type == T_WORD) {
+        if (tok_is(stream, tok, "if")) return parse_compound_redirects(parse_if(stream), stream);
+        if (tok_is(stream, tok, "for")) return parse_compound_redirects(parse_for(stream), stream);
+        if (tok_is(stream, tok, "while")) return parse_compound_redirects(parse_while(stream), stream);
+        if (tok_is(stream, tok, "{")) return parse_compound_redirects(parse_group(stream), stream);
+    }
+    if (tok && tok->type == T_PAREN && tok_is(stream, tok, "("))
+        return parse_compound_redirects(parse_subshell(stream), stream);
+    return parse_simple(stream);
+}
+
+// 단계 하나를 읽고 원문 범위를 기록한다 (time의 단계별 출력용)
+static Command *parse_stage(TokenStream *stream) {
+    Token *first = peek_token(stream);
+    Command *cmd = parse_compound_or_simple(stream);
+    if (!cmd || !first) return cmd;
+
+    int end = first->start;
+    for (int i = stream->pos - 1; i >= 0; i--) {
+        Token *last = &stream->tokens[i];
+        if (last->type != T_COMMENT && last->type != T_EOF) {
+            end = last->start + last->len;
+            break;
+        }
+    }
+    cmd->text = stream->src + first->start;
+    cmd->text_len = end > first->start ? end - first->start : 0;
+    return cmd;
+}
+
 Command *parse_pipeline(TokenStream *stream) {
-    Command *left = parse_simple(stream);
+    // time 파이프라인: 뒤따르는 파이프라인(또는 복합 명령어) 전체의 자원 사용량을 출력
+    Token *tok = peek_token(stream);
+    if (tok && tok->type == T_WORD && tok_is(stream, tok, "time") &&
+        !(stream->pos + 1 < stream->count && (stream->tokens[stream->pos + 1].flags & TF_JOINED))) {
+        next_token(stream);
+        Command *cmd = new_command(stream, CMD_TIME);
+        Token *next = peek_token(stream);
+        if (next && next->type != T_EOF && !is_separator(stream, next))
+            cmd->left = parse_pipeline(stream);
+        return cmd;
+    }
+
+    Command *left = parse_stage(stream);
     if (!left) return NULL;
 
     while (true) {
-        Token *tok = peek_token(stream);
-        if (!tok || tok->type != T_OPERATOR || strcmp(tok->value, "|") != 0)
+        tok = peek_token(stream);
+        if (!tok || tok->type != T_OPERATOR || !tok_is(stream, tok, "|"))
             break;
 
         next_token(stream);  // '|' 소비
-        Command *right = parse_simple(stream);
+        skip_newlines(stream);
+        Command *right = parse_stage(stream);
         if (!right) {
             fprintf(stderr, "Error: expected command after '|'\n");
-            free_command(left);
             return NULL;
         }
 
-        Command *pipe = malloc(sizeof(Command));
-        memset(pipe, 0, sizeof(Command));
-        pipe->type = CMD_PIPE;
+        Command *pipe = new_command(stream, CMD_PIPE);
         pipe->left = left;
         pipe->right = right;
 
@@ -286,19 +531,19 @@ Command *parse_pipeline(TokenStream *stream) {
 
 
 Command *parse_simple(TokenStream *stream) {
-    Command *cmd = malloc(sizeof(Command));
-    memset(cmd, 0, sizeof(Command));
-    cmd->type = CMD_SIMPLE;
+    Command *cmd = new_command(stream, CMD_SIMPLE);
+    cmd->args = arena_alloc(stream->arena, (count_arg_tokens(stream) + 1) * sizeof(char *));
 
     int argc = 0;
     Token *tok;
 
     while ((tok = peek_token(stream)) != NULL) {
-        if (tok->type == T_WORD || tok->type == T_VARIABLE || tok->type == T_STRING) {
-            tok = next_token(stream);
-            cmd->args[argc++] = strdup(tok->value);
-        } else if (tok->type == T_OPERATOR && is_redirect_operator(tok->value)) {
+        if (token_is_wordpart(tok)) {
+            cmd->args[argc++] = parse_word(stream, &cmd->expand);
+        } else if (tok->type == T_OPERATOR && is_redirect_operator(stream->src + tok->start, tok->len)) {
             parse_redirects(cmd, stream);
+        } else if (tok->type == T_HEREDOC) {
+            parse_heredoc(cmd, stream);
         } else {
             break;
         }
@@ -308,36 +553,14 @@ Command *parse_simple(TokenStream *stream) {
     return cmd;
 }
 
+// if/while의 조건부: end_token(then, do) 앞까지
 Command *parse_until(TokenStream *stream, const char *end_token) {
-    Command *left = parse_logical(stream);
-    if (!left) return NULL;
-
-    while (1) {
-        Token *tok = peek_token(stream);
-        if (!tok || tok->type != T_OPERATOR || strcmp(tok->value, ";") != 0)
-            break;
-
-        next_token(stream); // consume ';'
-        tok = peek_token(stream);
-        if (!tok || (tok->type == T_WORD && strcmp(tok->value, end_token) == 0))
-            break;
-
-        Command *right = parse_logical(stream);
-        if (!right) break;
-
-        Command *seq = malloc(sizeof(Command));
-        memset(seq, 0, sizeof(Command));
-        seq->type = CMD_SEQUENCE;
-        seq->left = left;
-        seq->right = right;
-        left = seq;
-    }
-
-    return left;
+    return parse_sequence_until(stream, end_token);
 }
 
 
 Command *parse_sequence(TokenStream *stream) {
+    Token *first = peek_token(stream);
     Command *left = parse_logical(stream);
     if (!left) return NULL;
 
@@ -345,22 +568,22 @@ Command *parse_sequence(TokenStream *stream) {
         Token *tok = peek_token(stream);
         if (!tok) break;
 
-        if (tok->type == T_OPERATOR && strcmp(tok->value, "&") == 0) {
+        if (tok->type == T_OPERATOR && tok_is(stream, tok, "&")) {
             next_token(stream); // '&' 소비
 
-            Command *bg = calloc(1, sizeof(Command));
-            bg->type = CMD_BACKGROUND;
+            Command *bg = new_command(stream, CMD_BACKGROUND);
             bg->left = left;
+            left->text = stream->src + first->start;
+            left->text_len = tok->start - first->start;
 
             Token *next = peek_token(stream);
 
-            // 다음에 또 명령어가 있다면 시퀀스로 이어붙이기
-            if (next && next->type != T_EOF) {
+            // 같은 줄에 또 명령어가 있다면 시퀀스로 이어붙이기 (do ... & done 처럼 블록이 끝나면 아님)
+            if (!is_block_end(stream, next, NULL) && !is_newline(stream, next)) {
                 Command *right = parse_sequence(stream);
                 if (!right) return bg;
 
-                Command *seq = calloc(1, sizeof(Command));
-                seq->type = CMD_SEQUENCE;
+                Command *seq = new_command(stream, CMD_SEQUENCE);
                 seq->left = bg;
                 seq->right = right;
                 return seq;
@@ -369,16 +592,15 @@ Command *parse_sequence(TokenStream *stream) {
             }
         }
 
-        if (tok->type == T_OPERATOR && strcmp(tok->value, ";") == 0) {
+        if (tok->type == T_OPERATOR && tok_is(stream, tok, ";")) {
             next_token(stream);
             Token *next = peek_token(stream);
-            if (!next || next->type == T_EOF) break;
+            if (!next || next->type == T_EOF || is_newline(stream, next)) break;
 
             Command *right = parse_logical(stream);
             if (!right) break;
 
-            Command *seq = calloc(1, sizeof(Command));
-            seq->type = CMD_SEQUENCE;
+            Command *seq = new_command(stream, CMD_SEQUENCE);
             seq->left = left;
             seq->right = right;
             left = seq;
@@ -392,24 +614,44 @@ Command *parse_sequence(TokenStream *stream) {
 
 
 
+// 복합 명령어의 본문: 구분자(; 또는 줄바꿈)로 이어진 명령어들을 end_token이나 다른 예약어 앞까지
+// 블록 안의 명령어 하나. 뒤에 &가 있으면 백그라운드 노드로 감싼다
+static Command *parse_block_item(TokenStream *stream) {
+    Token *first = peek_token(stream);
+    Command *cmd = parse_logical(stream);
+    Token *tok = peek_token(stream);
+    if (!cmd || !tok || tok->type != T_OPERATOR || !tok_is(stream, tok, "&"))
+        return cmd;
+
+    next_token(stream); // '&' 소비
+    cmd->text = stream->src + first->start;
+    cmd->text_len = tok->start - first->start;
+    Command *bg = new_command(stream, CMD_BACKGROUND);
+    bg->left = cmd;
+    return bg;
+}
+
 Command *parse_sequence_until(TokenStream *stream, const char *end_token) {
-    Command *left = parse_pipeline(stream);
+    skip_newlines(stream);
+    Command *left = parse_block_item(stream);
     if (!left) return NULL;
 
     Token *tok = peek_token(stream);
-    while (tok && tok->type == T_OPERATOR && strcmp(tok->value, ";") == 0) {
-        next_token(stream);
-        tok = peek_token(stream);
+    int after_bg = (left->type == CMD_BACKGROUND);   // &도 명령어를 구분함
+    while (after_bg || is_separator(stream, tok)) {
+        while (is_separator(stream, tok)) {   // 빈 줄, 연속된 구분자 건너뛰기
+            next_token(stream);
+            tok = peek_token(stream);
+        }
 
-        if (tok && strcmp(tok->value, end_token) == 0)
+        if (is_block_end(stream, tok, end_token))
             break;
 
-        Command *right = parse_pipeline(stream);
+        Command *right = parse_block_item(stream);
         if (!right) break;
+        after_bg = (right->type == CMD_BACKGROUND);
 
-        Command *seq = malloc(sizeof(Command));
-        memset(seq, 0, sizeof(Command));
-        seq->type = CMD_SEQUENCE;
+        Command *seq = new_command(stream, CMD_SEQUENCE);
         seq->left = left;
         seq->right = right;
 
@@ -421,36 +663,33 @@ Command *parse_sequence_until(TokenStream *stream, const char *end_token) {
 
 Command *parse_if(TokenStream *stream) {
     Token *tok = next_token(stream); // consume 'if'
-    if (!tok || strcmp(tok->value, "if") != 0) {
+    if (!tok || !tok_is(stream, tok, "if")) {
         fprintf(stderr, "Error: expected 'if'\n");
         return NULL;
     }
 
-    Command *cmd = calloc(1, sizeof(Command));
-    cmd->type = CMD_IF;
+    Command *cmd = new_command(stream, CMD_IF);
 
     // condition 파싱을 then 이전까지만
     cmd->condition = parse_until(stream, "then");
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "then") != 0) {
+    if (!tok || !tok_is(stream, tok, "then")) {
         fprintf(stderr, "Error: expected 'then'\n");
-        free_command(cmd);
         return NULL;
     }
 
     cmd->then_block = parse_sequence_until(stream, "else");
 
     tok = peek_token(stream);
-    if (tok && strcmp(tok->value, "else") == 0) {
+    if (tok && tok_is(stream, tok, "else")) {
         next_token(stream);
         cmd->else_block = parse_sequence_until(stream, "fi");
     }
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "fi") != 0) {
+    if (!tok || !tok_is(stream, tok, "fi")) {
         fprintf(stderr, "Error: expected 'fi'\n");
-        free_command(cmd);
         return NULL;
     }
 
@@ -460,58 +699,78 @@ Command *parse_if(TokenStream *stream) {
 
 Command *parse_for(TokenStream *stream) {
     Token *tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "for") != 0) {
+    if (!tok || !tok_is(stream, tok, "for")) {
         fprintf(stderr, "Error: expected 'for'\n");
         return NULL;
     }
 
-    Command *cmd = malloc(sizeof(Command));
-    memset(cmd, 0, sizeof(Command));
-    cmd->type = CMD_FOR;
+    Command *cmd = new_command(stream, CMD_FOR);
+
+    // for -j N x in ... : 반복을 최대 N개의 자식 프로세스에서 동시에 (0이면 CPU 개수)
+    tok = peek_token(stream);
+    if (tok && tok->type == T_WORD && tok->len >= 2 && strncmp(stream->src + tok->start, "-j", 2) == 0) {
+        next_token(stream);
+        const char *num = stream->src + tok->start + 2;
+        int num_len = tok->len - 2;
+        if (num_len == 0) {
+            tok = next_token(stream);
+            if (!tok || tok->type != T_WORD) {
+                fprintf(stderr, "Error: expected number after 'for -j'\n");
+                return NULL;
+            }
+            num = stream->src + tok->start;
+            num_len = tok->len;
+        }
+        cmd->parallel = 0;
+        for (int i = 0; i < num_len; i++) {
+            if (!isdigit((unsigned char)num[i])) {
+                fprintf(stderr, "Error: invalid job count after 'for -j'\n");
+                return NULL;
+            }
+            cmd->parallel = cmd->parallel * 10 + (num[i] - '0');
+        }
+        if (cmd->parallel == 0) cmd->parallel = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (cmd->parallel < 1) cmd->parallel = 1;
+    }
 
     tok = next_token(stream);
     if (!tok || tok->type != T_WORD) {
         fprintf(stderr, "Error: expected variable after 'for'\n");
-        free(cmd);
         return NULL;
     }
-    cmd->args[0] = strdup(tok->value);
+    Token *var = tok;
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "in") != 0) {
+    if (!tok || !tok_is(stream, tok, "in")) {
         fprintf(stderr, "Error: expected 'in' after variable\n");
-        free(cmd->args[0]);
-        free(cmd);
         return NULL;
     }
 
+    int nwords = 0;
+    while (stream->pos + nwords < stream->count && token_is_wordpart(&stream->tokens[stream->pos + nwords]))
+        nwords++;
+    cmd->args = arena_alloc(stream->arena, (nwords + 2) * sizeof(char *));
+    cmd->args[0] = tok_dup(stream, var);
+
     int argc = 1;
-    while ((tok = peek_token(stream)) && tok->type == T_WORD) {
-        tok = next_token(stream);
-        cmd->args[argc++] = strdup(tok->value);
-    }
+    while ((tok = peek_token(stream)) && token_is_wordpart(tok))
+        cmd->args[argc++] = parse_word(stream, &cmd->expand);
     cmd->args[argc] = NULL;
 
-    tok = peek_token(stream);
-    if (tok && tok->type == T_OPERATOR && strcmp(tok->value, ";") == 0)
+    while (is_separator(stream, peek_token(stream)))   // ; 또는 줄바꿈 뒤에 do
         next_token(stream);
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "do") != 0) {
+    if (!tok || !tok_is(stream, tok, "do")) {
         fprintf(stderr, "Error: expected 'do'\n");
-        for (int i = 0; i < argc; i++) free(cmd->args[i]);
-        free(cmd);
         return NULL;
     }
 
     cmd->then_block = parse_sequence_until(stream, "done");
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "done") != 0) {
+    if (!tok || !tok_is(stream, tok, "done")) {
         fprintf(stderr, "Error: expected 'done'\n");
-        for (int i = 0; i < argc; i++) free(cmd->args[i]);
-        free_command(cmd->then_block);
-        free(cmd);
         return NULL;
     }
 
@@ -520,42 +779,34 @@ Command *parse_for(TokenStream *stream) {
 
 Command *parse_while(TokenStream *stream) {
     Token *tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "while") != 0) {
+    if (!tok || !tok_is(stream, tok, "while")) {
         fprintf(stderr, "Error: expected 'while'\n");
         return NULL;
     }
 
-    Command *cmd = malloc(sizeof(Command));
-    memset(cmd, 0, sizeof(Command));
-    cmd->type = CMD_WHILE;
+    Command *cmd = new_command(stream, CMD_WHILE);
 
-    cmd->condition = parse_command(stream);
+    // condition 파싱을 do 이전까지만
+    cmd->condition = parse_until(stream, "do");
     if (!cmd->condition) {
         fprintf(stderr, "Error: expected condition after 'while'\n");
-        free(cmd);
         return NULL;
     }
 
-    tok = peek_token(stream);
-    if (tok && tok->type == T_OPERATOR && strcmp(tok->value, ";") == 0)
+    while (is_separator(stream, peek_token(stream)))   // ; 또는 줄바꿈 뒤에 do
         next_token(stream);
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "do") != 0) {
+    if (!tok || !tok_is(stream, tok, "do")) {
         fprintf(stderr, "Error: expected 'do'\n");
-        free_command(cmd->condition);
-        free(cmd);
         return NULL;
     }
 
     cmd->then_block = parse_sequence_until(stream, "done");
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "done") != 0) {
+    if (!tok || !tok_is(stream, tok, "done")) {
         fprintf(stderr, "Error: expected 'done'\n");
-        free_command(cmd->condition);
-        free_command(cmd->then_block);
-        free(cmd);
         return NULL;
     }
 
@@ -564,21 +815,18 @@ Command *parse_while(TokenStream *stream) {
 
 Command *parse_group(TokenStream *stream) {
     Token *tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "{") != 0) {
+    if (!tok || !tok_is(stream, tok, "{")) {
         fprintf(stderr, "Error: expected '{'\n");
         return NULL;
     }
 
-    Command *cmd = malloc(sizeof(Command));
-    memset(cmd, 0, sizeof(Command));
-    cmd->type = CMD_GROUP;
+    Command *cmd = new_command(stream, CMD_GROUP);
 
     cmd->left = parse_sequence_until(stream, "}");
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "}") != 0) {
+    if (!tok || !tok_is(stream, tok, "}")) {
         fprintf(stderr, "Error: expected '}'\n");
-        free_command(cmd);
         return NULL;
     }
 
@@ -587,44 +835,83 @@ Command *parse_group(TokenStream *stream) {
 
 Command *parse_subshell(TokenStream *stream) {
     Token *tok = next_token(stream);
-    if (!tok || strcmp(tok->value, "(") != 0) {
+    if (!tok || !tok_is(stream, tok, "(")) {
         fprintf(stderr, "Error: expected '('\n");
         return NULL;
     }
 
-    Command *cmd = malloc(sizeof(Command));
-    memset(cmd, 0, sizeof(Command));
-    cmd->type = CMD_SUBSHELL;
+    Command *cmd = new_command(stream, CMD_SUBSHELL);
 
     cmd->left = parse_sequence_until(stream, ")");
 
     tok = next_token(stream);
-    if (!tok || strcmp(tok->value, ")") != 0) {
+    if (!tok || !tok_is(stream, tok, ")")) {
         fprintf(stderr, "Error: expected ')'\n");
-        free_command(cmd);
         return NULL;
     }
 
     return cmd;
 }
 
+// 토큰 목록이 명령어 중간에서 끝났는지 (if/for/while/{/( 가 닫히지 않음, 끝이 | && ||).
+// 블록을 여는 예약어는 명령어 자리에 올 때만 센다. scan에 이어서 볼 위치를 저장해 두므로
+// 토큰이 늘어날 때마다 불러도 새 토큰만 본다 (처음에는 0으로 초기화).
+// 따옴표나 heredoc 본문이 끝났는지는 tokenize_feed()가 알려 준다.
+int tokens_incomplete(const TokenList *list, BlockScan *scan) {
+    static const char *openers[] = { "if", "for", "while", "{", NULL };
+    static const char *closers[] = { "fi", "done", "}", NULL };
+    // 이 예약어 뒤에는 다시 명령어가 온다
+    static const char *leaders[] = { "if", "while", "then", "do", "else", "elif", "{", "!", NULL };
+
+    for (; scan->next < list->count; scan->next++) {
+        const Token *tok = &list->data[scan->next];
+        if (tok->type == T_COMMENT || tok->type == T_EOF) continue;
+        if (tok->type == T_HEREDOC && (tok->flags & TF_HEREDOC_BODY)) continue;
+
+        if (tok->type == T_PAREN) {
+            scan->depth += token_equals(list->src, tok, "(") ? 1 : -1;
+            scan->mid_command = 0;
+        } else if (tok->type == T_OPERATOR) {
+            scan->mid_command = is_redirect_operator(list->src + tok->start, tok->len);
+        } else if (!scan->mid_command && tok->type == T_WORD && !(tok->flags & TF_JOINED)) {
+            scan->mid_command = 1;
+            for (int k = 0; openers[k]; k++) {
+                if (token_equals(list->src, tok, openers[k])) scan->depth++;
+            }
+            for (int k = 0; closers[k]; k++) {
+                if (token_equals(list->src, tok, closers[k])) scan->depth--;
+            }
+            for (int k = 0; leaders[k]; k++) {
+                if (token_equals(list->src, tok, leaders[k])) scan->mid_command = 0;
+            }
+        } else {
+            scan->mid_command = 1;
+        }
+        if (!(tok->type == T_OPERATOR && token_equals(list->src, tok, "\n"))) {
+            scan->continued = tok->type == T_OPERATOR &&
+                (token_equals(list->src, tok, "|") || token_equals(list->src, tok, "&&") ||
+                 token_equals(list->src, tok, "||"));
+        }
+    }
+
+    return scan->depth > 0 || scan->continued;
+}
+
 Command *parse_command(TokenStream *stream) {
   // parse_command()
 Command *cmd = parse_sequence(stream);
 Token *tok = peek_token(stream);
-if (tok && tok->type == T_OPERATOR && strcmp(tok->value, "&") == 0) {
+if (tok && tok->type == T_OPERATOR && tok_is(stream, tok, "&")) {
     next_token(stream);
 
     // 다음 토큰 확인
     Token *next = peek_token(stream);
-    if (next && next->type != T_EOF && !(next->type == T_OPERATOR && strcmp(next->value, ";") == 0)) {
+    if (next && next->type != T_EOF && !is_separator(stream, next)) {
         fprintf(stderr, "Error: '&' must be followed by EOF or ';'\n");
         return NULL;
     }
 
-    Command *bg = malloc(sizeof(Command));
-    memset(bg, 0, sizeof(Command));
-    bg->type = CMD_BACKGROUND;
+    Command *bg = new_command(stream, CMD_BACKGROUND);
     bg->left = cmd;
     return bg;
 }
@@ -715,6 +1002,10 @@ void print_command_tree(Command *cmd, int indent) {
             printf("BACKGROUND\n");
             print_command_tree(cmd->left, indent + 1);
     break;
+        case CMD_TIME:
+            printf("TIME\n");
+            print_command_tree(cmd->left, indent + 1);
+            break;
 
         default:
             printf("UNKNOWN COMMAND TYPE\n");
@@ -2,6 +2,7 @@
 #define PARSER_H
 
 #include "tokenizer.h"
+#include "arena.h"
 #include <stdbool.h>
 
 // 명령어 종류 정의
@@ -16,13 +17,33 @@ typedef enum {
     CMD_SEQUENCE,
     CMD_BACKGROUND,
     CMD_OR,
-    CMD_AND
+    CMD_AND,
+    CMD_TIME
 } CommandType;
 
 // 리다이렉션 구조체
+#define HEREDOC_EXPAND 0x1       // 구분자에 따옴표가 없음: 본문의 $... 를 확장
+#define HEREDOC_STRIP_TABS 0x2   // <<- : 각 줄 앞의 탭 제거
+
+// 연산자는 파싱할 때 한 번 해석해 두고, 실행할 때는 종류대로 시스템 콜만 한다
+typedef enum {
+    REDIR_OPEN,          // file을 flags로 열어 fd에 (<, >, >>, <>, &>, &>>)
+    REDIR_DUP,           // dup2(target_fd, fd) (2>&1, <&3)
+    REDIR_CLOSE,         // close(fd) (2>&-)
+    REDIR_HEREDOC,       // 본문을 fd 0에 (<<, <<-)
+    REDIR_UNSUPPORTED
+} RedirKind;
+
 typedef struct Redirect {
-    char *op;
+    char *op;                // 원래 연산자 (오류 메시지, 트리 출력용)
+    RedirKind kind;
+    int fd;                  // 바뀌는 fd (2>의 2, 없으면 < 는 0, > 는 1)
+    int target_fd;           // REDIR_DUP: 복제할 fd. REDIR_OPEN: 같은 파일을 받을 두 번째 fd (&> 의 2), 없으면 -1
+    int flags;               // REDIR_OPEN: open() 플래그 (O_CLOEXEC 포함)
     char *file;
+    const char *body;        // heredoc 본문 (입력 버퍼를 그대로 가리킴, NUL로 끝나지 않음)
+    size_t body_len;
+    int heredoc_flags;       // HEREDOC_*
     struct Redirect *next;
 } Redirect;
 
@@ -34,9 +55,12 @@ typedef struct Command {
     struct Command *condition;
     struct Command *then_block;
     struct Command *else_block;
-    char *args[20];
-    Redirect *redirects;
-    char *heredoc_body;
+    char **args;                 // NULL로 끝나는 인자 배열 (arena 할당, 확장 표시가 들어 있을 수 있음)
+    int expand;                  // args나 리다이렉션 파일 이름에 확장할 것이 있으면 1
+    Redirect *redirects;         // heredoc도 여기에 ("<<" 연산자). 복합 명령어면 본문 전체에 적용
+    const char *text;            // 명령어의 원문 (작업 표시, time 단계별 출력용. 입력 버퍼를 가리킴)
+    int text_len;
+    int parallel;                // for -j N 의 N (0이면 차례대로)
     int background;
 } Command;
 
@@ -45,8 +69,18 @@ typedef struct {
     Token *tokens;
     int count;
     int pos;
+    const char *src;  // 토큰들이 가리키는 입력 버퍼
+    Arena *arena;     // 파싱 결과(노드, 문자열, 리다이렉션)를 할당할 arena
 } TokenStream;
 
+// tokens_incomplete()가 어디까지 봤는지 (토큰이 늘어나면 이어서 봄)
+typedef struct {
+    int next;          // 다음에 볼 토큰 번호
+    int depth;         // 닫히지 않은 블록 수
+    int mid_command;   // 명령어 자리가 아니면 1 (예약어로 보지 않음)
+    int continued;     // 마지막 토큰이 | && || 이면 1
+} BlockScan;
+
 // 파싱 관련 함수
 Command *parse_command(TokenStream *stream);
 Command *parse_if(TokenStream *stream);
@@ -56,21 +90,22 @@ Command *parse_group(TokenStream *stream);
 Command *parse_subshell(TokenStream *stream);
 Command *parse_simple(TokenStream *stream);
 Command *parse_logical(TokenStream *stream);
+Command *parse_compound_or_simple(TokenStream *stream);
 // 파싱 보조 함수
 Token *next_token(TokenStream *stream);
 Token *peek_token(TokenStream *stream);
 bool match_token(TokenStream *stream, const char *value);
-int split_tokens(Token *tokens, int count, const char *sep);
-int is_redirect_operator(const char *op);
+int split_tokens(const char *src, Token *tokens, int count, const char *sep);
+int is_redirect_operator(const char *op, int len);
 int needs_filename(const char *op);
+int tokens_incomplete(const TokenList *list, BlockScan *scan);   // 입력이 더 와야 명령어가 끝나면 1
 
 // 속성 처리 함수
 void parse_redirects(Command *cmd, TokenStream *stream);
 void parse_heredoc(Command *cmd, TokenStream *stream);
 void parse_background(Command *cmd, TokenStream *stream);
 
-// 트리 출력 및 해제
+// 트리 출력 (트리의 해제는 arena_reset()으로 한 번에)
 void print_command_tree(Command *cmd, int indent);
-void free_command(Command *cmd);
 Command *parse_sequence(TokenStream *stream);
 #endif // PARSER_H
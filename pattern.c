@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "pattern.h"
+
+typedef enum { PAT_LITERAL, PAT_ANY, PAT_STAR, PAT_SET } PatOpType;
+
+typedef struct {
+    PatOpType type;
+    size_t start, len;          // PAT_LITERAL: lit 안의 위치
+    unsigned char set[32];      // PAT_SET: 256비트 문자 집합
+} PatOp;
+
+struct Pattern {
+    char *text;                 // 캐시 키 (원래 패턴)
+    PatOp *ops;
+    int nops;
+    char *lit;                  // 이스케이프를 푼 리터럴 글자들
+    size_t min_len;
+    int literal;                // 와일드카드가 하나도 없으면 1
+};
+
+static Pattern cache[PATTERN_CACHE_SIZE];
+static int cache_next = 0;      // 다음에 교체할 칸 (순환)
+
+static void set_bit(unsigned char *set, unsigned char c) {
+    set[c >> 3] |= 1 << (c & 7);
+}
+
+static int has_bit(const unsigned char *set, unsigned char c) {
+    return set[c >> 3] & (1 << (c & 7));
+}
+
+// [:alpha:] 같은 문자 클래스
+static int add_char_class(unsigned char *set, const char *name, size_t len) {
+    static const struct { const char *name; int (*fn)(int); } classes[] = {
+        { "alpha", isalpha }, { "digit", isdigit }, { "alnum", isalnum }, { "space", isspace },
+        { "upper", isupper }, { "lower", islower }, { "punct", ispunct }, { "xdigit", isxdigit },
+        { "blank", isblank }, { "cntrl", iscntrl }, { "print", isprint }, { "graph", isgraph },
+        { NULL, NULL }
+    };
+    for (int i = 0; classes[i].name; i++) {
+        if (strlen(classes[i].name) == len && strncmp(classes[i].name, name, len) == 0) {
+            for (int c = 0; c < 256; c++) {
+                if (classes[i].fn(c)) set_bit(set, c);
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// p는 '[' 다음 글자. 닫는 ']' 다음 위치를 반환하고, 괄호가 닫히지 않으면 NULL
+static const char *compile_set(const char *p, unsigned char *set) {
+    int negate = 0;
+    memset(set, 0, 32);
+
+    if (*p == '!' || *p == '^') { negate = 1; p++; }
+    const char *first = p;
+    while (*p && (*p != ']' || p == first)) {
+        if (*p == '[' && p[1] == ':') {
+            const char *close = strstr(p + 2, ":]");
+            if (close && add_char_class(set, p + 2, close - p - 2)) {
+                p = close + 2;
+                continue;
+            }
+        }
+        unsigned char lo = (unsigned char)*p;
+        if (*p == '\\' && p[1]) lo = (unsigned char)*++p;
+        p++;
+        if (*p == '-' && p[1] && p[1] != ']') {
+            unsigned char hi = (unsigned char)p[1];
+            if (p[1] == '\\' && p[2]) hi = (unsigned char)*++p;
+            p += 2;
+            for (int c = lo; c <= hi; c++) set_bit(set, c);
+        } else {
+            set_bit(set, lo);
+        }
+    }
+    if (*p != ']') return NULL;
+    if (negate) {
+        for (int i = 0; i < 32; i++) set[i] = ~set[i];
+    }
+    return p + 1;
+}
+
+static void compile(Pattern *pat, const char *text) {
+    size_t n = strlen(text);
+    pat->ops = malloc((n + 1) * sizeof(PatOp));
+    pat->lit = malloc(n + 1);
+    pat->nops = 0;
+    pat->min_len = 0;
+    pat->literal = 1;
+    if (!pat->ops || !pat->lit) {
+        perror("pattern");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t lit_len = 0;
+    const char *p = text;
+    while (*p) {
+        PatOp *op = &pat->ops[pat->nops];
+        if (*p == '*') {
+            while (*p == '*') p++;          // ** 는 * 하나와 같음
+            op->type = PAT_STAR;
+            pat->nops++;
+            pat->literal = 0;
+            continue;
+        }
+        if (*p == '?') {
+            op->type = PAT_ANY;
+            pat->nops++;
+            pat->min_len++;
+            pat->literal = 0;
+            p++;
+            continue;
+        }
+        if (*p == '[') {
+            const char *next = compile_set(p + 1, op->set);
+            if (next) {
+                op->type = PAT_SET;
+                pat->nops++;
+                pat->min_len++;
+                pat->literal = 0;
+                p = next;
+                continue;
+            }
+            // 닫히지 않은 [ 는 글자 그대로
+        }
+        if (*p == '\\' && p[1]) p++;
+
+        // 앞의 연산이 리터럴이면 이어 붙인다
+        if (pat->nops > 0 && pat->ops[pat->nops - 1].type == PAT_LITERAL) {
+            pat->ops[pat->nops - 1].len++;
+        } else {
+            op->type = PAT_LITERAL;
+            op->start = lit_len;
+            op->len = 1;
+            pat->nops++;
+        }
+        pat->lit[lit_len++] = *p++;
+        pat->min_len++;
+    }
+    pat->lit[lit_len] = '\0';
+}
+
+const Pattern *pattern_get(const char *text) {
+    for (int i = 0; i < PATTERN_CACHE_SIZE; i++) {
+        if (cache[i].text && strcmp(cache[i].text, text) == 0) return &cache[i];
+    }
+
+    Pattern *pat = &cache[cache_next];
+    cache_next = (cache_next + 1) % PATTERN_CACHE_SIZE;
+    free(pat->text);
+    free(pat->ops);
+    free(pat->lit);
+
+    pat->text = strdup(text);
+    if (!pat->text) {
+        perror("pattern");
+        exit(EXIT_FAILURE);
+    }
+    compile(pat, text);
+    return pat;
+}
+
+int pattern_is_literal(const Pattern *pat, const char **lit, size_t *len) {
+    if (!pat->literal) return 0;
+    *lit = pat->lit;
+    *len = pat->min_len;
+    return 1;
+}
+
+size_t pattern_min_len(const Pattern *pat) {
+    return pat->min_len;
+}
+
+// 마지막 * 위치로 되돌아가며 맞춰 보는 방식 (재귀 없음)
+int pattern_match(const Pattern *pat, const char *s, size_t n) {
+    int i = 0, star = -1;
+    size_t j = 0, star_j = 0;
+
+    if (n < pat->min_len) return 0;
+
+    while (1) {
+        if (i < pat->nops) {
+            const PatOp *op = &pat->ops[i];
+            switch (op->type) {
+                case PAT_STAR:
+                    star = i++;
+                    star_j = j;
+                    continue;
+                case PAT_LITERAL:
+                    if (j + op->len <= n && memcmp(s + j, pat->lit + op->start, op->len) == 0) {
+                        i++;
+                        j += op->len;
+                        continue;
+                    }
+                    break;
+                case PAT_ANY:
+                    if (j < n) { i++; j++; continue; }
+                    break;
+                case PAT_SET:
+                    if (j < n && has_bit(op->set, (unsigned char)s[j])) { i++; j++; continue; }
+                    break;
+            }
+        } else if (j == n) {
+            return 1;
+        }
+
+        // 맞지 않음: 마지막 *가 한 글자 더 먹도록 하고 다시 시도
+        if (star < 0 || star_j >= n) return 0;
+        i = star + 1;
+        j = ++star_j;
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stddef.h>
+
+// 쉘 glob 패턴 (* ? [...])을 미리 컴파일해 두고 문자열 조각과 맞춰 본다.
+// ${v#p}, ${v%p}, ${v/p/r} 같은 매개변수 연산에서 사용한다.
+
+#define PATTERN_CACHE_SIZE 32
+
+typedef struct Pattern Pattern;
+
+const Pattern *pattern_get(const char *text);   // 컴파일된 패턴 (최근 것은 캐시에서 재사용)
+int pattern_match(const Pattern *pat, const char *s, size_t n);   // s[0..n) 전체가 맞으면 1
+int pattern_is_literal(const Pattern *pat, const char **lit, size_t *len);   // 와일드카드가 없으면 1
+size_t pattern_min_len(const Pattern *pat);     // 맞을 수 있는 가장 짧은 길이
+
+#endif // PATTERN_H
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pwd.h>
+#include "prompt.h"
+#include "builtins.h"
+#include "vars.h"
+
+static char user[256] = "?";
+static char host[256] = "?";
+static char cwd_display[PROMPT_BUF_SIZE] = "?";   // HOME은 ~로 축약한 경로
+static char *home = NULL;
+static int is_root = 0;
+static char prompt_buf[PROMPT_BUF_SIZE];
+
+void prompt_init(void) {
+    struct passwd *pw = getpwuid(geteuid());
+    if (pw == NULL) perror("getpwuid 실패");
+    else snprintf(user, sizeof(user), "%s", pw->pw_name);
+
+    if (gethostname(host, sizeof(host)) != 0) perror("gethostname 실패");
+    host[sizeof(host) - 1] = '\0';
+
+    const char *h = var_get("HOME");
+    home = h ? strdup(h) : NULL;
+    is_root = (geteuid() == 0);
+
+    prompt_update_cwd();
+}
+
+void prompt_update_cwd(void) {
+    char cwd[PROMPT_BUF_SIZE];
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        perror("getcwd 실패");
+        return;
+    }
+
+    size_t home_len = home ? strlen(home) : 0;
+    if (home_len > 0 && strncmp(cwd, home, home_len) == 0 &&
+        (cwd[home_len] == '/' || cwd[home_len] == '\0')) {
+        snprintf(cwd_display, sizeof(cwd_display), "~%s", cwd + home_len);
+    } else {
+        snprintf(cwd_display, sizeof(cwd_display), "%s", cwd);
+    }
+}
+
+// 버퍼 끝을 넘지 않게 문자열을 덧붙인다
+static size_t append(size_t len, const char *s) {
+    size_t n = strlen(s);
+    if (len + n >= sizeof(prompt_buf)) n = sizeof(prompt_buf) - 1 - len;
+    memcpy(prompt_buf + len, s, n);
+    return len + n;
+}
+
+// PS1/PS2 형식 문자열을 그려서 출력
+static void draw_prompt(const char *fmt) {
+    size_t len = 0;
+    for (const char *p = fmt; *p && len < sizeof(prompt_buf) - 1; p++) {
+        if (*p != '\\' || !p[1]) {
+            prompt_buf[len++] = *p;
+            continue;
+        }
+        switch (*++p) {
+            case 'u': len = append(len, user); break;
+            case 'h': len = append(len, host); break;
+            case 'w': len = append(len, cwd_display); break;
+            case 'W': {
+                const char *base = strrchr(cwd_display, '/');
+                len = append(len, (base && base[1]) ? base + 1 : cwd_display);
+                break;
+            }
+            case '$': prompt_buf[len++] = is_root ? '#' : '$'; break;
+            case 'n': prompt_buf[len++] = '\n'; break;
+            case '\\': prompt_buf[len++] = '\\'; break;
+            default:
+                prompt_buf[len++] = '\\';
+                if (len < sizeof(prompt_buf) - 1) prompt_buf[len++] = *p;
+                break;
+        }
+    }
+
+    out_flush();   // 앞서 쌓인 출력이 있으면 순서를 지키도록 먼저 내보냄
+    if (write(STDOUT_FILENO, prompt_buf, len) < 0) perror("write");
+}
+
+void show_prompt(void) {
+    const char *fmt = var_get("PS1");
+    draw_prompt(fmt ? fmt : PROMPT_DEFAULT_FORMAT);
+}
+
+void show_continuation_prompt(void) {
+    const char *fmt = var_get("PS2");
+    draw_prompt(fmt ? fmt : PROMPT_CONTINUATION_FORMAT);
+}
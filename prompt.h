@@ -0,0 +1,21 @@
+#ifndef PROMPT_H
+#define PROMPT_H
+
+// 프롬프트 구성 요소(사용자, 호스트, 현재 디렉터리)를 캐시해 두고
+// 미리 할당한 버퍼에 그려서 write() 한 번으로 출력한다.
+//
+// 형식은 환경변수 PS1로 바꿀 수 있다:
+//   \u 사용자  \h 호스트  \w 현재 디렉터리(~ 축약)  \W 마지막 경로 요소
+//   \$ root면 #, 아니면 $  \n 줄바꿈  \\ 백슬래시
+// 명령어가 다음 줄로 이어질 때 (닫히지 않은 따옴표, heredoc, if ... 등)는 PS2를 쓴다.
+
+#define PROMPT_DEFAULT_FORMAT "\\u@\\h:\\w$ "
+#define PROMPT_CONTINUATION_FORMAT "> "
+#define PROMPT_BUF_SIZE 4096
+
+void prompt_init(void);          // 시작할 때 사용자/호스트를 한 번만 조회
+void prompt_update_cwd(void);    // 디렉터리가 바뀌었을 때만 호출 (cd 내장 명령어)
+void show_prompt(void);
+void show_continuation_prompt(void);   // PS2
+
+#endif // PROMPT_H
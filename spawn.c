@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include "spawn.h"
+#include "vars.h"
+
+// 리다이렉션 기록 하나를 spawn file action으로 옮긴다. 표현할 수 없으면 -1
+// (apply_redirection()과 같은 기록을 그대로 쓴다). REDIR_OPEN의 파일은 부모가 opened_fd로 미리 열어 둠
+static int add_redirect_action(posix_spawn_file_actions_t *fa, Redirect *redir, int opened_fd) {
+    switch (redir->kind) {
+        case REDIR_OPEN:
+            if (posix_spawn_file_actions_adddup2(fa, opened_fd, redir->fd)) return -1;
+            if (redir->target_fd >= 0)      // &>
+                return posix_spawn_file_actions_adddup2(fa, opened_fd, redir->target_fd) ? -1 : 0;
+            return 0;
+        case REDIR_DUP:
+            return posix_spawn_file_actions_adddup2(fa, redir->target_fd, redir->fd) ? -1 : 0;
+        case REDIR_CLOSE:
+            return posix_spawn_file_actions_addclose(fa, redir->fd) ? -1 : 0;
+        default:
+            return -1;  // heredoc 등 → fork 경로에서 처리
+    }
+}
+
+static void close_opened(int *opened, int count) {
+    for (int i = 0; i < count; i++) {
+        if (opened[i] >= 0) close(opened[i]);
+    }
+}
+
+// 리다이렉션할 파일을 부모에서 미리 연다 (O_CLOEXEC라 dup2한 사본만 자식에 남음).
+// posix_spawn()의 addopen이 실패하면 exec 실패와 구별되지 않아 명령어 탓으로 보고되므로,
+// 열 수 없으면 SPAWN_FALLBACK: fork 경로가 파일 이름으로 오류를 내고 상태 1로 끝난다.
+// 연 fd가 리다이렉션 대상 번호와 겹치지 않도록 대상들보다 큰 번호로 옮긴다.
+static int open_redirect_files(Command *cmd, int *opened) {
+    int count = 0, max_fd = STDERR_FILENO;
+    for (Redirect *r = cmd->redirects; r; r = r->next) {
+        if (r->fd > max_fd) max_fd = r->fd;
+        if (r->target_fd > max_fd) max_fd = r->target_fd;
+    }
+
+    for (Redirect *r = cmd->redirects; r; r = r->next, count++) {
+        if (count >= SPAWN_MAX_REDIRECTS) {
+            close_opened(opened, count);
+            return SPAWN_FALLBACK;
+        }
+        opened[count] = -1;
+        if (r->kind != REDIR_OPEN) continue;
+
+        int fd = open(r->file, r->flags, 0644);
+        if (fd >= 0 && fd <= max_fd) {
+            int moved = fcntl(fd, F_DUPFD_CLOEXEC, max_fd + 1);
+            close(fd);
+            fd = moved;
+        }
+        if (fd < 0) {
+            close_opened(opened, count);
+            return SPAWN_FALLBACK;
+        }
+        opened[count] = fd;
+    }
+    return count;
+}
+
+pid_t spawn_command(Command *cmd, const char *path, int in_fd, int out_fd, int own_group) {
+    posix_spawn_file_actions_t fa;
+    posix_spawnattr_t attr;
+    pid_t pid;
+    int err;
+
+    if (!cmd || cmd->type != CMD_SIMPLE || !cmd->args[0])
+        return SPAWN_FALLBACK;  // 자식 쪽 쉘 로직이 필요한 경우
+
+    int opened[SPAWN_MAX_REDIRECTS];
+    int nopened = open_redirect_files(cmd, opened);
+    if (nopened < 0) return SPAWN_FALLBACK;
+
+    if ((err = posix_spawn_file_actions_init(&fa)) != 0) {
+        fprintf(stderr, "posix_spawn: %s\n", strerror(err));
+        close_opened(opened, nopened);
+        return -1;
+    }
+
+    // 파이프 연결이 먼저, 명령어 자신의 리다이렉션이 나중 (fork 경로와 같은 순서)
+    if (in_fd >= 0 && in_fd != STDIN_FILENO)
+        posix_spawn_file_actions_adddup2(&fa, in_fd, STDIN_FILENO);
+    if (out_fd >= 0 && out_fd != STDOUT_FILENO)
+        posix_spawn_file_actions_adddup2(&fa, out_fd, STDOUT_FILENO);
+    int i = 0;
+    for (Redirect *r = cmd->redirects; r; r = r->next, i++) {
+        if (add_redirect_action(&fa, r, opened[i]) < 0) {
+            posix_spawn_file_actions_destroy(&fa);
+            close_opened(opened, nopened);
+            return SPAWN_FALLBACK;  // file action으로 표현할 수 없는 리다이렉션
+        }
+    }
+
+    // 자기 프로세스 그룹: 터미널의 Ctrl-C/Ctrl-Z가 가지 않고, fg가 터미널을 넘겨줄 수 있음
+    if (own_group) {
+        posix_spawnattr_init(&attr);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attr, 0);
+    }
+    err = posix_spawn(&pid, path, &fa, own_group ? &attr : NULL, cmd->args, var_environ());
+    posix_spawn_file_actions_destroy(&fa);
+    if (own_group) posix_spawnattr_destroy(&attr);
+    close_opened(opened, nopened);
+
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", cmd->args[0], strerror(err));
+        errno = err;
+        return -1;
+    }
+    return pid;
+}
@@ -0,0 +1,18 @@
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include <sys/types.h>
+#include "parser.h"
+
+// fork() 대신 posix_spawn()(glibc에서는 CLONE_VM|CLONE_VFORK)으로 단순 명령어를 실행한다.
+// 쉘의 힙/매핑 크기와 무관하게 실행 비용이 일정하다.
+
+#define SPAWN_FALLBACK (-2)   // spawn으로 표현할 수 없음 → 호출자가 fork 경로로 처리
+#define SPAWN_MAX_REDIRECTS 16   // 이보다 리다이렉션이 많으면 fork 경로로
+
+// 실행 후 pid 반환, 실패 시 -1, 지원하지 않는 명령어면 SPAWN_FALLBACK
+// in_fd/out_fd: stdin/stdout으로 연결할 fd (-1이면 그대로)
+// own_group: 1이면 자식을 자기 프로세스 그룹에 넣는다 (작업 제어가 켜진 백그라운드 작업)
+pid_t spawn_command(Command *cmd, const char *path, int in_fd, int out_fd, int own_group);
+
+#endif // SPAWN_H
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+#include "builtins.h"
+#include "vars.h"
+
+int stats_enabled = 0;
+
+typedef struct {
+    uint64_t count, total, min, max;
+    uint64_t buckets[STATS_BUCKETS];
+} Histogram;
+
+static Histogram hist[STAT_COUNT];
+static const char *phase_names[STAT_COUNT] = {
+    "tokenize", "parse", "expand", "spawn", "child", "reap"
+};
+
+// 아직 거두지 않은 자식의 시작 시각 (pid 0이면 빈 칸)
+static struct {
+    pid_t pid;
+    uint64_t when;
+} children[STATS_MAX_CHILDREN];
+static int next_child = 0;
+
+uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void stats_record(StatPhase phase, uint64_t ns) {
+    Histogram *h = &hist[phase];
+    int bucket = 63 - __builtin_clzll(ns | 1);
+    h->buckets[bucket]++;
+    if (h->count == 0 || ns < h->min) h->min = ns;
+    if (ns > h->max) h->max = ns;
+    h->count++;
+    h->total += ns;
+}
+
+void stats_child_started(pid_t pid, uint64_t when) {
+    children[next_child].pid = pid;       // 가득 차면 가장 오래된 칸을 덮어씀
+    children[next_child].when = when;
+    next_child = (next_child + 1) % STATS_MAX_CHILDREN;
+}
+
+uint64_t stats_child_start(pid_t pid) {
+    for (int i = 0; i < STATS_MAX_CHILDREN; i++) {
+        if (children[i].pid == pid) {
+            children[i].pid = 0;
+            return children[i].when;
+        }
+    }
+    return 0;
+}
+
+void stats_init(void) {
+    const char *value = var_get("MONGSHELL_STATS");
+    stats_enabled = value && *value && strcmp(value, "0") != 0;
+}
+
+// 1.5us, 20ms 처럼 읽기 쉬운 단위로
+static const char *format_ns(uint64_t ns, char *buf, size_t size) {
+    if (ns < 1000) snprintf(buf, size, "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000) snprintf(buf, size, "%.1fus", ns / 1e3);
+    else if (ns < 1000000000) snprintf(buf, size, "%.1fms", ns / 1e6);
+    else snprintf(buf, size, "%.2fs", ns / 1e9);
+    return buf;
+}
+
+static void print_histogram(const char *name, const Histogram *h) {
+    char a[32], b[32], c[32];
+    out_printf("%s: count %llu  avg %s  min %s  max %s\n", name, (unsigned long long)h->count,
+               format_ns(h->total / h->count, a, sizeof(a)), format_ns(h->min, b, sizeof(b)),
+               format_ns(h->max, c, sizeof(c)));
+
+    uint64_t peak = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        if (h->buckets[i] > peak) peak = h->buckets[i];
+    }
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        if (!h->buckets[i]) continue;
+        int bar = (int)((h->buckets[i] * 40 + peak - 1) / peak);
+        out_printf("  %8s .. %-8s %10llu %.*s\n", format_ns(1ull << i, a, sizeof(a)),
+                   format_ns(i < 63 ? 1ull << (i + 1) : UINT64_MAX, b, sizeof(b)),
+                   (unsigned long long)h->buckets[i], bar,
+                   "****************************************");
+    }
+}
+
+// shellstats [-r]: 단계별 히스토그램 출력 (-r이면 출력한 뒤 비움)
+int builtin_shellstats(char **args) {
+    int reset = 0;
+    for (int i = 1; args[i]; i++) {
+        if (strcmp(args[i], "-r") == 0) reset = 1;
+        else {
+            err_printf("shellstats: %s: invalid option\n", args[i]);
+            return 2;
+        }
+    }
+
+    if (!stats_enabled) out_printf("shellstats: instrumentation is off (set -o stats)\n");
+    for (int p = 0; p < STAT_COUNT; p++) {
+        if (hist[p].count) print_histogram(phase_names[p], &hist[p]);
+    }
+    if (reset) memset(hist, 0, sizeof(hist));
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+// 단계별 지연 시간 히스토그램 (shellstats 내장 명령어로 출력)
+// 환경 변수 MONGSHELL_STATS=1 또는 set -o stats로 켠다.
+// 꺼져 있으면 STATS_BEGIN/STATS_END는 전역 변수 하나만 확인하고 시계를 읽지 않는다.
+
+typedef enum {
+    STAT_TOKENIZE,   // tokenize()
+    STAT_PARSE,      // parse_command()
+    STAT_EXPAND,     // 인자/리다이렉션/for 목록 확장
+    STAT_SPAWN,      // posix_spawn() 또는 fork()가 돌아올 때까지 (spawn은 exec까지 포함)
+    STAT_CHILD,      // 자식을 만든 뒤부터 끝난 것을 알아챌 때까지
+    STAT_REAP,       // 끝난 자식을 wait4()로 거두는 데 걸린 시간
+    STAT_COUNT
+} StatPhase;
+
+#define STATS_BUCKETS 64       // [2^i, 2^(i+1)) ns
+#define STATS_MAX_CHILDREN 64  // 시작 시각을 기억해 둘 자식 수 (파이프라인 단계 수만큼)
+
+extern int stats_enabled;
+
+uint64_t stats_now(void);                        // CLOCK_MONOTONIC, ns
+void stats_record(StatPhase phase, uint64_t ns);
+void stats_child_started(pid_t pid, uint64_t when);
+uint64_t stats_child_start(pid_t pid);           // 모르면 0 (기록에서 지움)
+void stats_init(void);                           // MONGSHELL_STATS 확인 (vars_init 뒤에)
+
+#define STATS_BEGIN(var) uint64_t var = stats_enabled ? stats_now() : 0
+#define STATS_END(phase, var) do { if (stats_enabled) stats_record(phase, stats_now() - (var)); } while (0)
+
+int builtin_shellstats(char **args);
+
+#endif // STATS_H
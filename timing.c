@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include "timing.h"
+#include "builtins.h"
+#include "stats.h"
+
+static TimingFrame frames[TIMING_MAX_DEPTH];
+static int depth = 0;     // frames 중 쓰는 개수 (넘치면 재지 않고 세기만)
+
+void timing_begin(Command *target) {
+    if (depth++ >= TIMING_MAX_DEPTH) return;
+    TimingFrame *f = &frames[depth - 1];
+    memset(f, 0, offsetof(TimingFrame, stages));
+    f->target = target;
+    getrusage(RUSAGE_SELF, &f->self);
+    getrusage(RUSAGE_CHILDREN, &f->children);
+    clock_gettime(CLOCK_MONOTONIC, &f->start);
+}
+
+void timing_child(const struct rusage *ru) {
+    int n = depth < TIMING_MAX_DEPTH ? depth : TIMING_MAX_DEPTH;
+    for (int i = 0; i < n; i++) {
+        if (ru->ru_maxrss > frames[i].maxrss) frames[i].maxrss = ru->ru_maxrss;
+    }
+}
+
+struct rusage *timing_stage_usage(Command *pipeline, Command **stages, int nstages) {
+    if (depth == 0 || depth > TIMING_MAX_DEPTH) return NULL;
+    TimingFrame *f = &frames[depth - 1];
+    if (f->target != pipeline || f->nstages) return NULL;
+    f->nstages = nstages;
+    memcpy(f->stages, stages, nstages * sizeof(Command *));
+    memset(f->stage_usage, 0, nstages * sizeof(struct rusage));
+    return f->stage_usage;
+}
+
+pid_t wait_child(pid_t pid, int *status, struct rusage *ru) {
+    struct rusage local;
+    pid_t r;
+    uint64_t exited = 0;
+    if (!ru) ru = &local;
+
+    // shellstats: 끝날 때까지는 WNOWAIT로 기다려서 자식 실행 시간과 거두는 시간을 나눠 잰다
+    if (stats_enabled) {
+        siginfo_t info;
+        while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) < 0 && errno == EINTR)
+            ;
+        exited = stats_now();
+        uint64_t started = stats_child_start(pid);
+        if (started) stats_record(STAT_CHILD, exited - started);
+    }
+    while ((r = wait4(pid, status, 0, ru)) < 0 && errno == EINTR)
+        ;
+    if (exited) stats_record(STAT_REAP, stats_now() - exited);
+    if (r > 0 && depth > 0) timing_child(ru);
+    return r;
+}
+
+static double tv_seconds(struct timeval tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// bash처럼 0m1.234s
+static void print_time(const char *name, double seconds) {
+    int minutes = (int)(seconds / 60);
+    fprintf(stderr, "%s\t%dm%.3fs\n", name, minutes, seconds - minutes * 60);
+}
+
+static void print_stage(int i, Command *stage, const struct rusage *ru) {
+    const char *text = stage->text ? stage->text : "";
+    int len = stage->text_len;
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == ' ')) len--;
+    int cut = len > TIMING_LABEL_WIDTH;
+    if (cut) len = TIMING_LABEL_WIDTH - 3;
+    fprintf(stderr, "%5d  %9.3fs %9.3fs %9ld KB %8ld/%-6ld %.*s%s\n", i + 1,
+            tv_seconds(ru->ru_utime), tv_seconds(ru->ru_stime), ru->ru_maxrss,
+            ru->ru_nvcsw, ru->ru_nivcsw, len, text, cut ? "..." : "");
+}
+
+void timing_end(void) {
+    if (depth == 0) return;
+    if (depth-- > TIMING_MAX_DEPTH) return;
+    TimingFrame *f = &frames[depth];
+
+    struct timespec now;
+    struct rusage self, children;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+
+    double real = (now.tv_sec - f->start.tv_sec) + (now.tv_nsec - f->start.tv_nsec) / 1e9;
+    double user = tv_seconds(self.ru_utime) - tv_seconds(f->self.ru_utime) +
+                  tv_seconds(children.ru_utime) - tv_seconds(f->children.ru_utime);
+    double sys = tv_seconds(self.ru_stime) - tv_seconds(f->self.ru_stime) +
+                 tv_seconds(children.ru_stime) - tv_seconds(f->children.ru_stime);
+    long nvcsw = (self.ru_nvcsw - f->self.ru_nvcsw) + (children.ru_nvcsw - f->children.ru_nvcsw);
+    long nivcsw = (self.ru_nivcsw - f->self.ru_nivcsw) + (children.ru_nivcsw - f->children.ru_nivcsw);
+    // 자식이 없었으면 (내장 명령어만) 쉘 자신의 최대 RSS
+    long maxrss = f->maxrss ? f->maxrss : self.ru_maxrss;
+
+    out_flush();   // 재는 동안 내장 명령어가 버퍼에 쓴 출력이 먼저
+    fprintf(stderr, "\n");
+    print_time("real", real);
+    print_time("user", user);
+    print_time("sys", sys);
+    fprintf(stderr, "maxrss\t%ld KB\n", maxrss);
+    fprintf(stderr, "ctxsw\t%ld voluntary, %ld involuntary\n", nvcsw, nivcsw);
+
+    if (f->nstages > 0) {
+        fprintf(stderr, "%5s  %10s %10s %12s %8s/%-6s %s\n", "stage", "user", "sys", "maxrss", "ctxsw v", "i", "command");
+        for (int i = 0; i < f->nstages; i++) print_stage(i, f->stages[i], &f->stage_usage[i]);
+    }
+}
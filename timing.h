@@ -0,0 +1,36 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "parser.h"
+#include "executer.h"
+
+// time 키워드: 뒤따르는 명령어의 실제 시간, user/sys 시간, 최대 RSS, 문맥 전환 횟수.
+// user/sys/문맥 전환은 시작과 끝의 getrusage(SELF + CHILDREN) 차이,
+// 최대 RSS는 재는 동안 wait4()로 거둔 자식들의 최댓값이다.
+// 대상이 파이프라인이면 execute_pipeline()이 단계별 rusage를 채워서 함께 출력한다.
+
+#define TIMING_MAX_DEPTH 16          // time 안의 time
+#define TIMING_LABEL_WIDTH 40        // 단계별 출력에서 명령어 원문을 자르는 길이
+
+typedef struct {
+    struct timespec start;
+    struct rusage self, children;    // 시작할 때의 사용량
+    long maxrss;                     // 거둔 자식의 최대 RSS (KB, 없으면 0)
+    Command *target;                 // time 뒤의 명령어
+    int nstages;                     // target이 파이프라인이면 단계 수
+    Command *stages[MAX_PIPELINE_STAGES];
+    struct rusage stage_usage[MAX_PIPELINE_STAGES];
+} TimingFrame;
+
+void timing_begin(Command *target);
+void timing_end(void);               // 가장 안쪽 time의 결과를 stderr에 출력
+void timing_child(const struct rusage *ru);   // 거둔 자식 하나 (재는 중이 아니면 아무것도 안 함)
+// pipeline이 time의 대상이면 단계별 rusage를 받을 배열 (stages는 출력할 때 원문으로 씀)
+struct rusage *timing_stage_usage(Command *pipeline, Command **stages, int nstages);
+// waitpid() 대신: EINTR이면 다시 기다리고, 거둔 자식의 사용량을 time에 더함
+pid_t wait_child(pid_t pid, int *status, struct rusage *ru);
+
+#endif // TIMING_H
@@ -1,17 +1,13 @@
 #include "tokenizer.h"
 
-#define STATE_STACK_MAX 128
-State state_stack[STATE_STACK_MAX];
-int state_stack_top = 0;                         // 상태 저장을 위한 스택
-
-void push_state(State s) {
-    if (state_stack_top < STATE_STACK_MAX)
-        state_stack[state_stack_top++] = s;         
+static void push_state(TokenList *list, State s) {
+    if (list->stack_top < STATE_STACK_MAX)
+        list->stack[list->stack_top++] = s;
 }                                                // 상태를 push하는 함수
 
-State pop_state() {
-    if (state_stack_top > 0)
-        return state_stack[--state_stack_top];
+static State pop_state(TokenList *list) {
+    if (list->stack_top > 0)
+        return list->stack[--list->stack_top];
     return NORMAL;
 }                                                // 상태를 pop하는 함수
 
@@ -20,241 +16,532 @@ const char *token_type_names[] = {
     "HEREDOC", "PATTERN", "PAREN", "EOF"
 };
 
-Token tokens[MAX_TOKENS];
-int token_count = 0;
-
-void add_token(TokenType type, const char *start, int len) {
-    if (token_count >= MAX_TOKENS) return;
-    Token *t = &tokens[token_count++];
-    int copy_len = len < MAX_TOKEN_LEN - 1 ? len : MAX_TOKEN_LEN - 1;  // 오버플로우 방지
-    strncpy(t->value, start, copy_len);
-    t->value[copy_len] = '\0';               // 토큰 문자열 복사
+void add_token(TokenList *list, TokenType type, const char *start, int len) {
+    if (list->count >= list->cap) {
+        int new_cap = list->cap ? list->cap * 2 : TOKEN_LIST_INITIAL_CAP;
+        Token *data = realloc(list->data, new_cap * sizeof(Token));
+        if (!data) {
+            perror("add_token");
+            exit(EXIT_FAILURE);
+        }
+        list->data = data;
+        list->cap = new_cap;
+    }
+    Token *t = &list->data[list->count++];
     t->type = type;                         // 토큰 종류 저장
+    t->start = start - list->src;           // 문자열은 복사하지 않고 위치만 기록
+    t->len = len;
+
+    // 공백 없이 이어진 단어 조각은 파서가 한 단어로 합칠 수 있도록 표시
+    if (token_is_wordpart(t)) {
+        t->flags = list->in_word ? TF_JOINED : 0;
+        list->in_word = 1;
+    } else {
+        t->flags = 0;
+        list->in_word = 0;
+    }
 }
 
-// 연산자 토큰 길이를 반환하는 함수
-int is_operator_token(const char *p) {
-    if (strncmp(p, "&&", 2) == 0) return 2;
-    if (strncmp(p, "||", 2) == 0) return 2;
-    if (strncmp(p, "&>>", 3) == 0) return 3;
-    if (strncmp(p, "&>", 2) == 0) return 2;
-    if (strncmp(p, ">>", 2) == 0) return 2;
-    if (strncmp(p, "<<", 2) == 0) return 2;
-    if (strncmp(p, "<>", 2) == 0) return 2;
-    // 나머지 FD 리다이렉션이나 단일 기호 처리 ...
+int token_is_wordpart(const Token *tok) {
+    return tok->type == T_WORD || tok->type == T_STRING || tok->type == T_VARIABLE ||
+           tok->type == T_COMMAND_SUB || tok->type == T_PATTERN;
+}
+
+// 마지막 토큰이 큰따옴표 안에서 나왔음을 표시
+static void mark_dquote(TokenList *list) {
+    list->data[list->count - 1].flags |= TF_DQUOTE;
+}
+
+// $?, $#, $$, $!, $@, $*, $-, $0-9 같은 한 글자 특수 매개변수인지
+static int is_special_param(char c) {
+    return c && strchr("?#$!@*-0123456789", c) != NULL;
+}
+
+int token_equals(const char *src, const Token *tok, const char *s) {
+    return strncmp(src + tok->start, s, tok->len) == 0 && s[tok->len] == '\0';
+}
+
+void free_tokens(TokenList *list) {
+    free(list->data);
+    list->data = NULL;
+    list->count = list->cap = 0;
+}
 
+// 문자 분류 테이블 (로케일과 무관한 256칸 테이블, 첫 tokenize() 호출 때 채움)
+#define CC_SPACE    0x01   // 공백류 (' ', \t, \n, \v, \f, \r)
+#define CC_DIGIT    0x02   // 0-9
+#define CC_IDSTART  0x04   // 변수 이름의 첫 글자 (A-Z, a-z, _)
+#define CC_OPERATOR 0x08   // 연산자 시작 문자 (& | ; < >)
+#define CC_WORDSTOP 0x10   // 단어 스캔을 멈추고 자세히 봐야 하는 문자
+
+static unsigned char char_class[256];
+
+static void init_char_class(void) {
+    static int initialized = 0;
+    if (initialized) return;
+
+    for (int c = 0; c < 256; c++) {
+        unsigned char cls = 0;
+        if (c == ' ' || (c >= '\t' && c <= '\r')) cls |= CC_SPACE | CC_WORDSTOP;
+        if (c >= '0' && c <= '9') cls |= CC_DIGIT | CC_WORDSTOP;  // 2> 같은 FD 리다이렉션 가능성
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_') cls |= CC_IDSTART;
+        if (c == '&' || c == '|' || c == ';' || c == '<' || c == '>') cls |= CC_OPERATOR | CC_WORDSTOP;
+        if (c == '(' || c == ')' || c == '$' || c == '\0') cls |= CC_WORDSTOP;
+        if (c == '\'' || c == '"' || c == '\\') cls |= CC_WORDSTOP;   // 따옴표, 이스케이프
+        char_class[c] = cls;
+    }
+    initialized = 1;
+}
+
+#define IS_SPACE(c)   (char_class[(unsigned char)(c)] & CC_SPACE)
+#define IS_DIGIT(c)   (char_class[(unsigned char)(c)] & CC_DIGIT)
+#define IS_IDSTART(c) (char_class[(unsigned char)(c)] & CC_IDSTART)
+#define IS_IDCHAR(c)  (char_class[(unsigned char)(c)] & (CC_IDSTART | CC_DIGIT))
+
+int is_operator_char(char c) {
+    init_char_class();
+    return (char_class[(unsigned char)c] & CC_OPERATOR) != 0;
+}
 
-    // FD + 리다이렉션 (예: 2>, 123>&1, 5<&-) 처리 구간간
+// FD + 리다이렉션 (예: 2>, 2>>, 123>&1, 5<&-) 길이, 아니면 0
+static int fd_redirect_len(const char *p) {
     const char *q = p;
-    while (isdigit(*q)) q++;  // FD 숫자 부분 스캔 (예: 2, 123)
-    if (*q == '>' || *q == '<') {
-        q++;
-        if (*q == '&') {
-            q++;  // 리다이렉션 기호 > 또는 <
-            while (isdigit(*q)) q++; // 뒤쪽 FD 숫자 스캔 (예: 1, 5)
-            if (*q == '-') q++;  // - 기호 (FD 닫기) 확인
-        }
-        return q - p;  // 전체 길이 반환 (예: 2>&1 → 4, 123>&- → 7)
+    while (IS_DIGIT(*q)) q++;  // FD 숫자 부분 스캔 (예: 2, 123)
+    if (*q != '>' && *q != '<') return 0;
+
+    if (q != p && q[0] == '>' && q[1] == '>') return q + 2 - p;  // 2>> (추가 모드)
+    q++;
+    if (*q == '&') {
+        q++;  // 리다이렉션 기호 > 또는 <
+        while (IS_DIGIT(*q)) q++; // 뒤쪽 FD 숫자 스캔 (예: 1, 5)
+        if (*q == '-') q++;  // - 기호 (FD 닫기) 확인
     }
+    return q - p;  // 전체 길이 반환 (예: 2>&1 → 4, 123>&- → 7)
+}
 
-    if (*p == '>' || *p == '<' || *p == '&' || *p == '|' || *p == ';') return 1;
+// 연산자 토큰 길이를 반환하는 함수 (첫 글자로 한 번에 분기)
+int is_operator_token(const char *p) {
+    switch (*p) {
+        case '&':
+            if (p[1] == '&') return 2;                   // &&
+            if (p[1] == '>') return p[2] == '>' ? 3 : 2; // &>>, &>
+            return 1;
+        case '|':
+            return p[1] == '|' ? 2 : 1;                  // ||, |
+        case ';':
+            return 1;
+        case '>':
+            if (p[1] == '>') return 2;                   // >>
+            return fd_redirect_len(p);                   // >, >&1, >&-
+        case '<':
+            if (p[1] == '<' || p[1] == '>') return 2;    // <<, <>
+            return fd_redirect_len(p);                   // <, <&0, <&-
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return fd_redirect_len(p);                   // 2>, 123>&1 ...
+        default:
+            return 0; // 연산자 아님
+    }
+}
 
-    return 0; // 연산자 아님
+// 특별한 의미가 없는 단어 문자들을 한 번에 건너뛴다.
+// CC_WORDSTOP 문자(또는 end) 위치를 반환하며, 벡터 버전은 그보다 넓은 집합에서 멈출 수 있다.
+static const char *skip_word_scalar(const char *p, const char *end) {
+    while (p < end && !(char_class[(unsigned char)*p] & CC_WORDSTOP)) p++;
+    return p;
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// 16바이트씩: 공백/제어문자(<= ' '), 숫자, & | ; < > ( ) $ ' " \ 중 하나라도 있으면 그 위치에서 멈춤
+__attribute__((target("sse2")))
+static const char *skip_word_sse2(const char *p, const char *end) {
+    const __m128i space = _mm_set1_epi8(' '), zero = _mm_set1_epi8('0'), nine = _mm_set1_epi8(9);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i d = _mm_sub_epi8(v, zero);
+        __m128i stop = _mm_cmpeq_epi8(_mm_max_epu8(v, space), space);       // v <= ' '
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d)); // '0' <= v <= '9'
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('&')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('|')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8(';')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('<')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('>')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('(')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8(')')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('$')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+        unsigned mask = _mm_movemask_epi8(stop);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return skip_word_scalar(p, end);
+}
 
-int is_pattern_char(char c) {
-    return c == '*' || c == '?' || c == '[';
+// 32바이트씩: SSE2 버전과 같은 집합
+__attribute__((target("avx2")))
+static const char *skip_word_avx2(const char *p, const char *end) {
+    const __m256i space = _mm256_set1_epi8(' '), zero = _mm256_set1_epi8('0'), nine = _mm256_set1_epi8(9);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i d = _mm256_sub_epi8(v, zero);
+        __m256i stop = _mm256_cmpeq_epi8(_mm256_max_epu8(v, space), space);
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('|')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(';')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('(')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(')')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+        stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+        unsigned mask = _mm256_movemask_epi8(stop);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return skip_word_sse2(p, end);
 }
+#endif
+
+static const char *(*skip_word)(const char *p, const char *end) = NULL;
+
+// CPU가 지원하는 가장 넓은 구현을 고른다 (AVX2 → SSE2 → 스칼라)
+static void select_skip_word(void) {
+    skip_word = skip_word_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) skip_word = skip_word_avx2;
+    else if (__builtin_cpu_supports("sse2")) skip_word = skip_word_sse2;
+#endif
+}
+
 
-void tokenize(const char *input) {
-    const char *p = input;       // 순회를 위한 포인터
-    const char *start = input;   // 시작 포인터
-    State state = NORMAL;        // 현재 상태 초기화
-    int depth = 0;               // 중첩 괄호 depth 관리
+// heredoc 연산자 뒤: 구분자 단어를 T_WORD로 내보내고, 본문 자리에 빈 T_HEREDOC 토큰을 둔다.
+// 본문은 이 줄이 끝난 뒤 IN_HEREDOC 상태에서 구분자 줄을 만날 때 채운다.
+// 입력 버퍼를 그대로 가리키므로 크기 제한도 복사도 없다.
+static const char *scan_heredoc(TokenList *list, const char *p, const char *end, int strip_tabs) {
+    char delim[HEREDOC_DELIM_MAX];
+    int dlen = 0;
+
+    while (*p == ' ' || *p == '\t') p++;
+    const char *word = p;
+    while (p < end && !IS_SPACE(*p) && !(char_class[(unsigned char)*p] & CC_OPERATOR)) {
+        if (*p == '\'' || *p == '"') {          // 'EOF', "EOF": 따옴표 제거
+            char quote = *p++;
+            while (p < end && *p != quote) {
+                if (dlen < (int)sizeof(delim) - 1) delim[dlen++] = *p;
+                p++;
+            }
+            if (p < end) p++;
+            continue;
+        }
+        if (*p == '\\' && p + 1 < end) p++;       // \EOF
+        if (dlen < (int)sizeof(delim) - 1) delim[dlen++] = *p;
+        p++;
+    }
+    if (p == word) return p;                    // 구분자가 없음: 파서가 오류를 낸다
+    add_token(list, T_WORD, word, p - word);
+
+    // 본문을 다 읽을 때까지는 '끝나지 않음'으로 둔다
+    add_token(list, T_HEREDOC, p, 0);
+    list->data[list->count - 1].flags |= TF_HEREDOC_BODY | TF_UNTERMINATED;
+    if (list->nheredocs >= HEREDOC_MAX_PENDING) {
+        fprintf(stderr, "warning: too many here-documents on one line\n");
+        return p;
+    }
+    PendingHeredoc *h = &list->heredocs[list->nheredocs++];
+    h->token = list->count - 1;
+    h->strip_tabs = strip_tabs;
+    h->dlen = dlen;
+    memcpy(h->delim, delim, dlen);
+    return p;
+}
 
-    while (*p) {
-        if (token_count >= MAX_TOKENS) { p++; continue; }  // MAX_TOKENS 초과 방어
+int is_pattern_char(char c) {
+    return c == '*' || c == '?' || c == '[';
+}
 
+// list->pos부터 list->len까지 토큰화한다. 입력이 중간에 끊기면 상태를 list에 저장해 두고
+// 돌아가서, 다음 호출이 그 자리부터 이어 간다 (이미 본 입력은 다시 보지 않음).
+// at_eof가 0이면 끝의 줄 이음(\)과 끝나지 않은 heredoc 줄은 입력이 더 올 때까지 남겨 둔다.
+static void scan(TokenList *list, int at_eof) {
+    const char *input = list->src;
+    const char *p = input + list->pos;         // 순회를 위한 포인터
+    const char *start = input + list->start;   // 시작 포인터
+    const char *end = input + list->len;       // 벡터 스캔이 넘지 않아야 할 경계
+    State state = list->state;                 // 현재 상태
+    int depth = list->depth;                   // 중첩 괄호 depth 관리
+    int dq_count = list->dq_count;
+
+    while (p < end) {
         switch (state) {
             case NORMAL:
-            if (isspace(*p) || *p == '\r') { p++; start = p; continue; }
-            if (*p == '#') { state = IN_COMMENT; start = p; p++; continue; }
-            if (*p == '\\' && *(p + 1) == ';') { add_token(T_WORD, p, 2); p += 2; start = p; continue; }
-            if (*p == '{' && *(p + 1) == '}') { add_token(T_WORD, p, 2); p += 2; start = p; continue; }
-            if (*p == '\\') { push_state(state); state = IN_ESCAPE; p++; continue; }
+            if (*p == '\n') {    // 줄바꿈은 명령어 구분자
+                add_token(list, T_OPERATOR, p, 1);
+                p++;
+                start = p;
+                list->line_count = list->count;
+                if (list->nheredocs > 0) {    // 이 줄에서 연 heredoc들의 본문이 이어진다
+                    state = IN_HEREDOC;
+                    list->heredoc_cur = 0;
+                }
+                continue;
+            }
+            if (*p == '\\' && p[1] == '\n') {       // 줄 이음
+                if (p + 2 >= end && !at_eof) goto suspend;
+                if (!list->in_word) { p += 2; start = p; continue; }
+            }
+            if (IS_SPACE(*p)) { list->in_word = 0; p++; start = p; continue; }
+            if (*p == '#' && !list->in_word) { state = IN_COMMENT; start = p; p++; continue; }
+            if (*p == '{' && *(p + 1) == '}') { add_token(list, T_WORD, p, 2); p += 2; start = p; continue; }
             if (*p == '\'') { state = IN_SQUOTE; start = ++p; continue; }
-            if (*p == '\"') { push_state(state); state = IN_DQUOTE; start = ++p; continue; }
-            if (*p == '$' && *(p + 1) == '{') { push_state(state); state = IN_VAR_EXPAND; start = p; p += 2; continue; }
-            if (*p == '$' && *(p + 1) == '(') { push_state(state); state = IN_CMD_SUBST; start = p; p += 2; depth = 1; continue; }
+            if (*p == '\"') { push_state(list, state); state = IN_DQUOTE; start = ++p; dq_count = list->count; continue; }
+            if (*p == '$' && *(p + 1) == '{') { push_state(list, state); state = IN_VAR_EXPAND; start = p; p += 2; depth = 1; continue; }
+            if (*p == '$' && *(p + 1) == '(') { push_state(list, state); state = IN_CMD_SUBST; start = p; p += 2; depth = 1; continue; }
 
-            int op_len = is_operator_token(p);  // ← 변경: is_operator_token() 호출 추가
+            int op_len = (char_class[(unsigned char)*p] & (CC_OPERATOR | CC_DIGIT)) ? is_operator_token(p) : 0;
             if (op_len > 0) {
-                if (op_len == 2 && strncmp(p, "<<", 2) == 0) {  // ← heredoc 구분 처리 추가
-                    add_token(T_HEREDOC, p, op_len);
-                    p += op_len;
-                    state = IN_HEREDOC;
+                if (op_len == 2 && p[0] == '<' && p[1] == '<') {  // heredoc: <<, <<-
+                    if (p[2] == '-') op_len = 3;
+                    add_token(list, T_HEREDOC, p, op_len);
+                    p = scan_heredoc(list, p + op_len, end, op_len == 3);
                     start = p;
                     continue;
                 }
-                add_token(T_OPERATOR, p, op_len);
+                add_token(list, T_OPERATOR, p, op_len);
                 p += op_len;
                 start = p;
                 continue;
             }
 
-            if (*p == '(' || *p == ')') { add_token(T_PAREN, p, 1); p++; start = p; continue; }
+            if (*p == '(' || *p == ')') { add_token(list, T_PAREN, p, 1); p++; start = p; continue; }
 
             if (*p == '[') {
-                if (p == input || isspace(*(p - 1))) {
-                    add_token(T_WORD, p, 1);
+                if (p == input || IS_SPACE(*(p - 1))) {
+                    add_token(list, T_WORD, p, 1);
                 } else {
-                    add_token(T_PATTERN, p, 1);
+                    add_token(list, T_PATTERN, p, 1);
                 }
                 p++;
                 start = p;
                 continue;
             }
 
-            if (is_pattern_char(*p)) { add_token(T_PATTERN, p, 1); p++; start = p; continue; }
-
-            if (*p == '-') {
-                start = p++;
-                while (*p && !isspace(*p) && *p != '\r') {
-                    int next_op_len = is_operator_token(p);
-                    if (next_op_len > 0) break;
-                    p++;
-                }
-                add_token(T_WORD, start, p - start);
-                continue;
-            }
+            if (is_pattern_char(*p)) { add_token(list, T_PATTERN, p, 1); p++; start = p; continue; }
 
             start = p;
-            while (*p) {
-                if (isspace(*p) || *p == '\r') break;
+            while (p < end) {
+                p = skip_word(p, end);  // 특별한 의미가 없는 문자들은 한 번에 건너뜀
+                if (p >= end || IS_SPACE(*p)) break;
                 int next_op_len = is_operator_token(p);
                 if (next_op_len > 0) break;
                 if (*p == '(' || *p == ')') break;
+                if (*p == '\'' || *p == '"') break;                          // 따옴표 부분은 이어지는 토큰으로
+                if (*p == '$' && (p[1] == '{' || p[1] == '(')) break;        // ${...}, $(...)
+                if (*p == '\\') {                                           // 이스케이프된 글자는 단어의 일부
+                    if (p[1] == '\n' && p + 2 >= end && !at_eof) { p = start; goto suspend; }  // 다음 줄에서 단어가 이어짐
+                    p += p[1] ? 2 : 1;
+                    continue;
+                }
 
-                if (*p == '$' && (isalpha(*(p + 1)) || *(p + 1) == '_')) {
-                    if (p > start) add_token(T_WORD, start, p - start);
+                if (*p == '$' && (IS_IDSTART(*(p + 1)) || is_special_param(p[1]))) {
+                    if (p > start) add_token(list, T_WORD, start, p - start);
                     start = p;
                     p++;
-                    while (isalnum(*p) || *p == '_') p++;
-                    add_token(T_VARIABLE, start, p - start);
+                    if (IS_IDSTART(*p)) while (IS_IDCHAR(*p)) p++;
+                    else p++;                                             // $?, $1 ... 은 한 글자
+                    add_token(list, T_VARIABLE, start, p - start);
                     start = p;
                     continue;
                 }
                 p++;
             }
-            if (p > start) add_token(T_WORD, start, p - start);
+            if (p > start) add_token(list, T_WORD, start, p - start);
             break;
 
             case IN_ESCAPE:
-                if (*p) p++;  
-                state = pop_state();
+                p++;
+                state = pop_state(list);
                 break;
 
-            case IN_SQUOTE:
-                if (*p == '\'') { add_token(T_STRING, start, p - start); p++; state = NORMAL; start = p; }
-                else p++;
+            case IN_SQUOTE: {
+                const char *q = memchr(p, '\'', end - p);  // 닫는 따옴표까지 한 번에 이동
+                if (!q) { p = end; break; }
+                p = q;
+                add_token(list, T_STRING, start, p - start); p++; state = NORMAL; start = p;  // '' 도 빈 단어
                 break;
+            }
 
             case IN_DQUOTE:
-                if (*p == '\"') { 
-                    if (p > start) add_token(T_STRING, start, p - start); 
-                    p++; state = pop_state(); start = p; }
-                else if (*p == '\\') { push_state(state); state = IN_ESCAPE; p++; }
-                else if (*p == '$' && *(p + 1) == '{') { 
-                    if (p > start) add_token(T_STRING, start, p - start);
-                    push_state(state); state = IN_VAR_EXPAND; start = p; p += 2; }
-                else if (*p == '$' && *(p + 1) == '(') { 
-                    if (p > start) add_token(T_STRING, start, p - start);
-                    push_state(state); state = IN_CMD_SUBST; start = p; p += 2; depth = 1; }
-                else if (*p == '$' && (isalpha(*(p + 1)) || *(p + 1) == '_')) { 
-                    if (p > start) add_token(T_STRING, start, p - start);
-                    push_state(state);  state = IN_VAR_EXPAND;  start = p; p++; }
+                if (*p == '\"') {
+                    // "" 처럼 안에서 아무 토큰도 나오지 않았으면 빈 문자열 토큰을 남긴다
+                    if (p > start || list->count == dq_count) { add_token(list, T_STRING, start, p - start); mark_dquote(list); }
+                    p++; state = pop_state(list); start = p; }
+                else if (*p == '\\') { push_state(list, state); state = IN_ESCAPE; p++; }
+                else if (*p == '$' && *(p + 1) == '{') {
+                    if (p > start) { add_token(list, T_STRING, start, p - start); mark_dquote(list); }
+                    push_state(list, state); state = IN_VAR_EXPAND; start = p; p += 2; depth = 1; }
+                else if (*p == '$' && *(p + 1) == '(') {
+                    if (p > start) { add_token(list, T_STRING, start, p - start); mark_dquote(list); }
+                    push_state(list, state); state = IN_CMD_SUBST; start = p; p += 2; depth = 1; }
+                else if (*p == '$' && IS_IDSTART(*(p + 1))) {
+                    if (p > start) { add_token(list, T_STRING, start, p - start); mark_dquote(list); }
+                    push_state(list, state);  state = IN_VAR_EXPAND;  start = p; p++; }
+                else if (*p == '$' && is_special_param(p[1])) {
+                    if (p > start) { add_token(list, T_STRING, start, p - start); mark_dquote(list); }
+                    add_token(list, T_VARIABLE, p, 2); mark_dquote(list);
+                    p += 2; start = p; }
                 else {
                     p++;  // 개선: DQUOTE 안에서는 is_operator_char 체크하지 않고 그냥 진행
                 }
                 break;
 
             case IN_COMMENT:
-                while (*p && *p != '\n' && *p != '\r') p++;  // \r\n 호환 추가
-                add_token(T_COMMENT, start, p - start);
+                while (p < end && *p != '\n' && *p != '\r') p++;  // \r\n 호환 추가
+                add_token(list, T_COMMENT, start, p - start);
                 state = NORMAL;
                 start = p;
                 break;
 
             case IN_VAR_EXPAND:
             if (*(start + 1) == '{') {
-                while (*p && *p != '}') p++;
-                if (*p == '}') p++;
+                // ${x:-${y}} 처럼 중첩될 수 있음 (depth는 ${ 를 열 때 1)
+                while (p < end && depth > 0) {
+                    if (*p == '\\' && p + 1 < end) p++;
+                    else if (*p == '{') depth++;
+                    else if (*p == '}') depth--;
+                    p++;
+                }
+                if (depth > 0) break;       // 닫는 } 가 아직 오지 않음
             } else {
-                while (isalnum(*p) || *p == '_') p++;
+                while (IS_IDCHAR(*p)) p++;
             }
-            add_token(T_VARIABLE, start, p - start);
-            state = pop_state();
+            state = pop_state(list);
+            add_token(list, T_VARIABLE, start, p - start);
+            if (state == IN_DQUOTE) mark_dquote(list);
             start = p;
             break;
         
         case IN_CMD_SUBST:
-            while (*p && depth > 0) {
+            while (p < end && depth > 0) {
                 if (*p == '$' && *(p + 1) == '(') { depth++; p += 2; continue; }
                 if (*p == ')') { depth--; p++; continue; }
                 p++;
             }
             if (depth == 0) {
-                add_token(T_COMMAND_SUB, start, p - start);
-                state = pop_state();
+                state = pop_state(list);
+                add_token(list, T_COMMAND_SUB, start, p - start);
+                if (state == IN_DQUOTE) mark_dquote(list);
                 start = p;
-            } else {
-                fprintf(stderr, "Error: unterminated state detected (%d)\n", state);
-                exit(EXIT_FAILURE);
             }
-            break;
-        
-            case IN_HEREDOC:
-            while (*p) {
-                if (*p == '\n' || *p == '\r') {
-                    p++;
-                    const char *line_start = p;
-                    const char *line_end = p;
-                    while (*line_end && *line_end != '\n' && *line_end != '\r') line_end++;
-
-                    int line_len = line_end - line_start;
-                    if (line_len == 3 && strncmp(line_start, "EOF", 3) == 0) {
-                        add_token(T_HEREDOC, start, line_start - start - 1);
-                        p = line_end;
-                        state = NORMAL;
-                        break;
-                    }
-                    p = line_end;
-                } else {
-                    p++;
-                }
+            break;                          // 닫는 ) 가 아직 오지 않았으면 입력이 더 올 때 이어서
+
+        case IN_HEREDOC: {
+            // 한 줄씩 보면서 구분자만 있는 줄을 찾는다 (<<- 이면 앞의 탭은 무시)
+            const PendingHeredoc *h = &list->heredocs[list->heredoc_cur];
+            const char *eol = memchr(p, '\n', end - p);
+            if (!eol) {
+                if (!at_eof) goto suspend;      // 줄의 나머지가 아직 오지 않음
+                eol = end;
             }
-
-            if (state == IN_HEREDOC) {
-                fprintf(stderr, "Error: unterminated HEREDOC detected\n");
-                exit(EXIT_FAILURE);
+            const char *text = p;
+            if (h->strip_tabs) while (text < eol && *text == '\t') text++;
+            int len = eol - text;
+            if (len > 0 && text[len - 1] == '\r') len--;
+            const char *next = eol < end ? eol + 1 : end;
+
+            if (len == h->dlen && memcmp(text, h->delim, len) == 0) {
+                Token *body = &list->data[h->token];
+                body->start = start - input;
+                body->len = p - start;
+                body->flags &= ~TF_UNTERMINATED;
+                start = next;
+                if (++list->heredoc_cur == list->nheredocs) {   // 이 줄의 본문을 모두 읽음
+                    list->nheredocs = list->heredoc_cur = 0;
+                    state = NORMAL;
+                }
             }
+            p = next;
             break;
-        
+        }
         }
     }
 
-    if (state != NORMAL) {
-        fprintf(stderr, "Warning: unterminated state detected (%d)\n", state);
-        exit(EXIT_FAILURE);
+suspend:
+    list->pos = p - input;
+    list->start = start - input;
+    list->state = state;
+    list->depth = depth;
+    list->dq_count = dq_count;
+}
+
+void tokenize_begin(TokenList *list) {
+    init_char_class();
+    if (!skip_word) select_skip_word();
+
+    list->count = 0;
+    list->in_word = 0;
+    list->len = list->pos = list->start = 0;
+    list->state = NORMAL;
+    list->stack_top = 0;
+    list->depth = 0;
+    list->dq_count = 0;
+    list->line_count = 0;
+    list->nheredocs = list->heredoc_cur = 0;
+}
+
+int tokenize_feed(TokenList *list, const char *input, int len) {
+    list->src = input;
+    list->len = len;
+    scan(list, 0);
+    return list->state == NORMAL && list->nheredocs == 0 && list->pos == list->len;
+}
+
+int tokenize_finish(TokenList *list) {
+    const char *input = list->src;
+    int result = 0;
+
+    scan(list, 1);
+    if (list->state == IN_HEREDOC || list->nheredocs > 0) {
+        // 구분자 줄 없이 끝난 본문은 입력 끝까지 (파서가 경고)
+        for (int i = list->heredoc_cur; i < list->nheredocs; i++) {
+            Token *body = &list->data[list->heredocs[i].token];
+            body->start = (i == list->heredoc_cur && list->state == IN_HEREDOC) ? list->start : list->len;
+            body->len = list->len - body->start;
+        }
+        list->nheredocs = list->heredoc_cur = 0;
+    } else if (list->state != NORMAL) {
+        State open = list->state == IN_ESCAPE ? list->stack[list->stack_top - 1] : list->state;
+        const char *wanted = open == IN_SQUOTE ? "'" : open == IN_DQUOTE ? "\"" :
+                             open == IN_CMD_SUBST ? ")" : "}";
+        fprintf(stderr, "syntax error: unexpected EOF while looking for matching `%s'\n", wanted);
+        list->count = list->line_count;     // 닫히지 않은 줄은 버린다
+        result = -1;
     }
+    list->state = NORMAL;
+    list->stack_top = 0;
+    list->in_word = 0;
+
+    add_token(list, T_EOF, input + list->len, 0);
+    return result;
+}
 
-    add_token(T_EOF, "", 0);
+int tokenize(TokenList *list, const char *input) {
+    tokenize_begin(list);
+    tokenize_feed(list, input, strlen(input));
+    return tokenize_finish(list);
 }
 
-void print_tokens() {
-    for (int i = 0; i < token_count; i++) {
-        printf("[%s] '%s'\n", token_type_names[tokens[i].type], tokens[i].value);
+void print_tokens(const TokenList *list) {
+    for (int i = 0; i < list->count; i++) {
+        const Token *t = &list->data[i];
+        printf("[%s] '%.*s'\n", token_type_names[t->type], t->len, list->src + t->start);
     }
 }
 
@@ -6,8 +6,10 @@
 #include <ctype.h>
 #include <stdlib.h>
 
-#define MAX_TOKEN_LEN 128
-#define MAX_TOKENS 256
+#define TOKEN_LIST_INITIAL_CAP 64
+#define STATE_STACK_MAX 128          // 중첩된 따옴표/확장 상태의 최대 깊이
+#define HEREDOC_MAX_PENDING 16       // 한 줄에서 본문을 기다릴 수 있는 heredoc 수
+#define HEREDOC_DELIM_MAX 256
 
 
 // 각 토큰의 종류를 구분하기 위한 열거형
@@ -24,22 +26,72 @@ typedef enum {
 } State;
 
 
+// 토큰 플래그
+#define TF_JOINED 0x1            // 앞 토큰과 공백 없이 붙어 있음 (같은 단어의 일부)
+#define TF_DQUOTE 0x2            // 큰따옴표 안에서 나온 토큰 (단어 분리 안 함)
+#define TF_HEREDOC_BODY 0x4      // << 연산자가 아니라 heredoc 본문 조각
+#define TF_UNTERMINATED 0x8      // 구분자 줄이 아직 (또는 입력 끝까지) 나오지 않은 heredoc 본문
+
+// 토큰은 입력 버퍼를 복사하지 않고 (시작 오프셋, 길이)로만 가리킨다
 typedef struct {
     TokenType type;              // 토큰의 종류
-    char value[MAX_TOKEN_LEN];   // 토큰의 문자열
+    int start;                   // 입력 버퍼에서의 시작 오프셋
+    int len;                     // 토큰의 길이
+    int flags;                   // TF_* 조합
 } Token;
 
+// 본문을 기다리는 heredoc (줄이 끝나면 다음 줄부터 본문을 읽는다)
+typedef struct {
+    int token;                   // 본문 토큰의 번호 (본문을 다 읽으면 위치와 길이를 채움)
+    int strip_tabs;              // <<- 이면 1
+    int dlen;
+    char delim[HEREDOC_DELIM_MAX];  // 따옴표를 벗긴 구분자
+} PendingHeredoc;
+
+// 필요할 때마다 두 배로 늘어나는 토큰 배열.
+// 토큰화 상태도 여기에 들고 있어서, 입력이 더 오면 멈춘 곳에서 이어서 토큰화한다.
+typedef struct {
+    Token *data;                 // 전체 토큰들을 저장하는 배열
+    int count;                   // 현재까지 저장된 토큰의 수
+    int cap;                     // 할당된 크기
+    const char *src;             // 토큰들이 가리키는 입력 버퍼 (feed할 때마다 바뀔 수 있음)
+    int in_word;                 // 직전 토큰 뒤로 아직 단어가 끝나지 않았으면 1
+
+    int len;                     // 지금까지 받은 입력 길이
+    int pos;                     // 다음에 볼 입력 오프셋
+    int start;                   // 진행 중인 토큰의 시작 오프셋
+    State state;                 // 현재 상태
+    State stack[STATE_STACK_MAX];   // 돌아갈 상태들 (큰따옴표 안의 $(...) 등)
+    int stack_top;
+    int depth;                   // ${...}의 중괄호, $(...)의 괄호 중첩 깊이
+    int dq_count;                // 큰따옴표를 열 때의 토큰 수 ("" 빈 문자열 판별용)
+    int line_count;              // 현재 줄이 시작할 때의 토큰 수 (오류 때 그 줄을 버림)
+    PendingHeredoc heredocs[HEREDOC_MAX_PENDING];
+    int nheredocs;               // 본문을 기다리는 heredoc 수
+    int heredoc_cur;             // 지금 본문을 읽고 있는 heredoc
+} TokenList;
+
 
 extern const char *token_type_names[];  // 이름 매핑을 위한 배열
-extern Token tokens[MAX_TOKENS];  // 전체 토큰들을 저장하는 배열
-extern int token_count;           // 현재까지 저장된 토큰의 수
 
 
-void add_token(TokenType type, const char *start, int len);  // 새로운 토큰 추가
+void add_token(TokenList *list, TokenType type, const char *start, int len);  // 새로운 토큰 추가
 int is_operator_char(char c);                                // 연산자 판별
 int is_pattern_char(char c);                                 // 패턴 문자 판별
-void tokenize(const char *input);                            // 토큰화 함수
-void print_tokens();                                         // 토큰 출력 함수
+// 한 번에 토큰화: begin + feed + finish. 닫히지 않은 입력이면 오류를 출력하고 -1
+int tokenize(TokenList *list, const char *input);            // 토큰화 함수 (list는 비우고 다시 채움)
+
+// 나눠서 토큰화: 입력이 줄 단위로 조금씩 올 때 (대화형, 파이프).
+// feed에는 지금까지 받은 입력 전체를 넘긴다 (input[len] == '\0', 앞서 넘긴 내용은 그대로이고
+// realloc으로 옮겨졌어도 됨). 앞에서 멈춘 상태부터 새로 온 부분만 보고,
+// 따옴표, $(, heredoc, 줄 이음(\)이 모두 닫혔으면 1을 돌려준다.
+void tokenize_begin(TokenList *list);
+int tokenize_feed(TokenList *list, const char *input, int len);
+int tokenize_finish(TokenList *list);                        // 입력 끝: T_EOF 추가. 닫히지 않았으면 -1
+void print_tokens(const TokenList *list);                    // 토큰 출력 함수
+void free_tokens(TokenList *list);                           // 토큰 배열 해제
+int token_equals(const char *src, const Token *tok, const char *s);  // 토큰 내용 비교
+int token_is_wordpart(const Token *tok);                     // 단어를 이루는 토큰인지 (WORD, STRING, VARIABLE ...)
 
 
 #endif // TOKENIZER_H
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "vars.h"
+#include "builtins.h"
+
+typedef struct {
+    char *env;          // "NAME=value" (NULL이면 빈 슬롯). 환경 배열이 이 문자열을 그대로 가리킴
+    size_t name_len;
+    size_t cap;         // env 버퍼 크기 (값이 들어갈 자리가 있으면 재할당하지 않음)
+    int flags;
+} Var;
+
+static Var *table = NULL;
+static size_t table_size = 0;      // 항상 2의 거듭제곱
+static size_t table_used = 0;
+
+static char **env_array = NULL;    // var_environ()이 돌려주는 배열
+static size_t env_cap = 0;
+static int env_dirty = 1;          // export된 변수가 바뀌었으면 1
+
+static unsigned long hash_name(const char *s, size_t len) {
+    unsigned long h = 5381;        // djb2
+    for (size_t i = 0; i < len; i++) h = h * 33 + (unsigned char)s[i];
+    return h;
+}
+
+// 선형 탐사로 name의 슬롯을 찾는다 (없으면 비어 있는 슬롯)
+static Var *find_slot(Var *tab, size_t size, const char *name, size_t len) {
+    size_t i = hash_name(name, len) & (size - 1);
+    while (tab[i].env && (tab[i].name_len != len || memcmp(tab[i].env, name, len) != 0))
+        i = (i + 1) & (size - 1);
+    return &tab[i];
+}
+
+static void grow_table(void) {
+    size_t new_size = table_size ? table_size * 2 : VARS_INITIAL_SIZE;
+    Var *new_tab = calloc(new_size, sizeof(Var));
+    if (!new_tab) return;
+
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].env)
+            *find_slot(new_tab, new_size, table[i].env, table[i].name_len) = table[i];
+    }
+    free(table);
+    table = new_tab;
+    table_size = new_size;
+}
+
+static Var *lookup(const char *name, size_t len) {
+    if (!table) return NULL;
+    Var *v = find_slot(table, table_size, name, len);
+    return v->env ? v : NULL;
+}
+
+int var_valid_name(const char *name, size_t len) {
+    if (len == 0 || !(isalpha((unsigned char)name[0]) || name[0] == '_')) return 0;
+    for (size_t i = 1; i < len; i++) {
+        if (!(isalnum((unsigned char)name[i]) || name[i] == '_')) return 0;
+    }
+    return 1;
+}
+
+static int set_n(const char *name, size_t name_len, const char *value, int flags) {
+    if ((table_used + 1) * 2 > table_size) grow_table();
+    if (!table) return -1;
+
+    Var *v = find_slot(table, table_size, name, name_len);
+    size_t value_len = strlen(value);
+    size_t need = name_len + value_len + 2;
+
+    if (!v->env || v->cap < need) {
+        // 새 항목이거나 값이 커졌을 때만 할당 (반복문 변수는 보통 여기를 지나지 않음)
+        size_t cap = need < 32 ? 32 : need * 2;
+        char *env = realloc(v->env, cap);
+        if (!env) return -1;
+        if (!v->env) {
+            memcpy(env, name, name_len);
+            env[name_len] = '=';
+            v->name_len = name_len;
+            v->flags = 0;
+            table_used++;
+        }
+        v->env = env;
+        v->cap = cap;
+        env_dirty = 1;             // 배열이 가리키는 주소가 바뀜
+    }
+    memcpy(v->env + name_len + 1, value, value_len + 1);
+
+    int was_exported = (v->flags & (VAR_EXPORT | VAR_SET)) == (VAR_EXPORT | VAR_SET);
+    v->flags |= flags | VAR_SET;
+    if (was_exported || (v->flags & VAR_EXPORT)) env_dirty = 1;
+    return 0;
+}
+
+void vars_init(char **envp) {
+    for (; envp && *envp; envp++) {
+        const char *eq = strchr(*envp, '=');
+        if (!eq) continue;
+        set_n(*envp, eq - *envp, eq + 1, VAR_EXPORT);
+    }
+}
+
+const char *var_get(const char *name) {
+    Var *v = lookup(name, strlen(name));
+    if (!v || !(v->flags & VAR_SET)) return NULL;
+    return v->env + v->name_len + 1;
+}
+
+int var_set(const char *name, const char *value, int flags) {
+    return set_n(name, strlen(name), value, flags);
+}
+
+int var_unset(const char *name) {
+    Var *v = lookup(name, strlen(name));
+    if (!v || !(v->flags & VAR_SET)) return 0;
+    // open addressing이라 슬롯은 비우지 않고 표시만 지운다
+    if (v->flags & VAR_EXPORT) env_dirty = 1;
+    v->flags = 0;
+    v->env[v->name_len + 1] = '\0';
+    return 0;
+}
+
+int var_export(const char *name) {
+    size_t len = strlen(name);
+    Var *v = lookup(name, len);
+    if (!v) {
+        // 값 없이 export만 된 변수: 나중에 값이 생기면 환경에 들어감
+        if (set_n(name, len, "", VAR_EXPORT) < 0) return -1;
+        lookup(name, len)->flags = VAR_EXPORT;
+        return 0;
+    }
+    if (!(v->flags & VAR_EXPORT)) {
+        v->flags |= VAR_EXPORT;
+        if (v->flags & VAR_SET) env_dirty = 1;
+    }
+    return 0;
+}
+
+char **var_environ(void) {
+    if (!env_dirty && env_array) return env_array;
+
+    size_t n = 0;
+    for (size_t i = 0; i < table_size; i++) {
+        if ((table[i].flags & (VAR_EXPORT | VAR_SET)) == (VAR_EXPORT | VAR_SET)) n++;
+    }
+    if (n + 1 > env_cap) {
+        char **grown = realloc(env_array, (n + 1) * 2 * sizeof(char *));
+        if (!grown) return env_array;
+        env_array = grown;
+        env_cap = (n + 1) * 2;
+    }
+
+    n = 0;
+    for (size_t i = 0; i < table_size; i++) {
+        if ((table[i].flags & (VAR_EXPORT | VAR_SET)) == (VAR_EXPORT | VAR_SET))
+            env_array[n++] = table[i].env;
+    }
+    env_array[n] = NULL;
+    env_dirty = 0;
+    return env_array;
+}
+
+// export NAME[=value]... / 인자가 없으면 export된 변수 목록 출력
+int builtin_export(char **args) {
+    int status = 0;
+
+    if (!args[1] || (strcmp(args[1], "-p") == 0 && !args[2])) {
+        for (size_t i = 0; i < table_size; i++) {
+            if (!table[i].env || !(table[i].flags & VAR_EXPORT)) continue;
+            if (table[i].flags & VAR_SET)
+                out_printf("export %.*s=\"%s\"\n", (int)table[i].name_len, table[i].env,
+                           table[i].env + table[i].name_len + 1);
+            else
+                out_printf("export %.*s\n", (int)table[i].name_len, table[i].env);
+        }
+        return 0;
+    }
+
+    for (int i = 1; args[i]; i++) {
+        const char *eq = strchr(args[i], '=');
+        size_t len = eq ? (size_t)(eq - args[i]) : strlen(args[i]);
+        if (!var_valid_name(args[i], len)) {
+            fprintf(stderr, "export: `%s': not a valid identifier\n", args[i]);
+            status = 1;
+            continue;
+        }
+        if (eq) set_n(args[i], len, eq + 1, VAR_EXPORT);
+        else var_export(args[i]);
+    }
+    return status;
+}
+
+int builtin_unset(char **args) {
+    int status = 0;
+    for (int i = 1; args[i]; i++) {
+        if (!var_valid_name(args[i], strlen(args[i]))) {
+            fprintf(stderr, "unset: `%s': not a valid identifier\n", args[i]);
+            status = 1;
+            continue;
+        }
+        var_unset(args[i]);
+    }
+    return status;
+}
@@ -0,0 +1,23 @@
+#ifndef VARS_H
+#define VARS_H
+
+// 쉘 변수 테이블 (이름으로 찾는 open addressing 해시)
+// export된 변수가 바뀌었을 때만 exec용 환경(envp) 배열을 다시 만든다.
+
+#define VARS_INITIAL_SIZE 128
+
+#define VAR_EXPORT 0x1   // 자식 프로세스 환경에 포함
+#define VAR_SET    0x2   // 값이 있음 (unset되면 슬롯만 남음)
+
+void vars_init(char **envp);                     // 시작할 때 환경 변수를 가져옴 (모두 export)
+const char *var_get(const char *name);           // 없으면 NULL
+int var_set(const char *name, const char *value, int flags);  // flags는 기존 플래그에 더해짐
+int var_unset(const char *name);
+int var_export(const char *name);
+int var_valid_name(const char *name, size_t len);
+char **var_environ(void);                        // exec에 넘길 NAME=value 배열
+
+int builtin_export(char **args);
+int builtin_unset(char **args);
+
+#endif // VARS_H